@@ -2,6 +2,7 @@
 #include <ap_int.h>
 #include <hls_math.h>
 #include "fitness_kernel.h"
+#include "fitness_kernel_impl.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,145 +11,59 @@ extern "C" {
 void fitness_kernel(
     hls::stream<packed_t>& chromosome_stream,
     hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
     const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
     int chromo_len,
     int dim,
     int num_bats,
-    bool mode
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
 ) {
     // --- INTERFACES ---
     #pragma HLS INTERFACE axis port=chromosome_stream
     #pragma HLS INTERFACE axis port=result_stream
-    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(MAX_GENES*MAX_DIM+WIDE_FLOATS-1)/WIDE_FLOATS max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=MAX_CHUNKS
     #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
     #pragma HLS INTERFACE s_axilite port=dim bundle=control
     #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
     #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
     #pragma HLS INTERFACE s_axilite port=return bundle=control
-    
-    // --- LOCAL STORAGE ---
-    static float local_vector_cache[MAX_GENES * MAX_DIM];
-    #pragma HLS ARRAY_PARTITION variable=local_vector_cache cyclic factor=PARTIAL_UNROLL dim=1
-    #pragma HLS BIND_STORAGE variable=local_vector_cache type=ram_2p impl=bram
 
-    // --- MODE 1: LOAD CACHE ---
-    if (mode == 1) {
-        int total_elements = chromo_len * dim;
-        
-        load_cache: for (int i = 0; i < total_elements; i++) {
-            #pragma HLS PIPELINE II=1
-            local_vector_cache[i] = vectors_in[i];
-        }
-        
-        result_stream.write(0.0f);
-    } 
-    // --- MODE 0: COMPUTE FITNESS ---
-    else {
-        // Fixed arrays with cyclic partitioning
-        float sumA[MAX_DIM];
-        float sumB[MAX_DIM];
-        #pragma HLS ARRAY_PARTITION variable=sumA cyclic factor=PARTIAL_UNROLL
-        #pragma HLS ARRAY_PARTITION variable=sumB cyclic factor=PARTIAL_UNROLL
-        
-        process_batches: for (int bat = 0; bat < num_bats; bat++) {
-            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
-            
-            // Initialize sums
-            init_sums: for (int i = 0; i < MAX_DIM; i++) {
-                #pragma HLS PIPELINE II=1
-                if (i < dim) {
-                    sumA[i] = 0.0f;
-                    sumB[i] = 0.0f;
-                }
-            }
-            
-            // --- FIX: Separate chromosome read loop ---
-            const int num_chunks = (chromo_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
-            
-            // Read all chromosome chunks first into a buffer
-            packed_t chromo_buffer[(MAX_GENES + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK];
-            #pragma HLS ARRAY_PARTITION variable=chromo_buffer cyclic factor=4
-            
-            read_chromosomes: for (int chunk = 0; chunk < num_chunks; chunk++) {
-                #pragma HLS PIPELINE II=1
-                chromo_buffer[chunk] = chromosome_stream.read();
-            }
-            
-            // Process genes using the buffered chromosome data
-            process_genes: for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
-                #pragma HLS PIPELINE II=1
-                
-                int chunk_idx = gene_idx / BITS_PER_CHUNK;
-                int bit_idx = gene_idx % BITS_PER_CHUNK;
-                bool gene_bit = chromo_buffer[chunk_idx][bit_idx];
-                int vector_base = gene_idx * dim;
-                
-                // Process dimensions with partial unroll - NO PIPELINE pragma inside
-                process_dims: for (int d_block = 0; d_block < dim; d_block += PARTIAL_UNROLL) {
-                    // Remove #pragma HLS PIPELINE from here - only partial unroll
-                    int d_end = d_block + PARTIAL_UNROLL;
-                    if (d_end > dim) d_end = dim;
-                    
-                    for (int d = d_block; d < d_end; d++) {
-                        #pragma HLS UNROLL
-                        float vector_val = local_vector_cache[vector_base + d];
-                        
-                        if (gene_bit == 0) {
-                            // Use standard floating-point addition
-                            float temp_sum = sumA[d];
-                            sumA[d] = temp_sum + vector_val;
-                        } else {
-                            // Use standard floating-point addition
-                            float temp_sum = sumB[d];
-                            sumB[d] = temp_sum + vector_val;
-                        }
-                    }
-                }
-            }
-            
-            // --- Compute Euclidean distance with hierarchical reduction ---
-            float distance_squared = 0.0f;
-            
-            // Use hierarchical reduction to avoid large unrolls
-            const int REDUCTION_GROUPS = 4;  // Adjust based on your needs
-            float group_sums[REDUCTION_GROUPS];
-            #pragma HLS ARRAY_PARTITION variable=group_sums complete
-            
-            // Initialize group sums
-            init_groups: for (int g = 0; g < REDUCTION_GROUPS; g++) {
-                #pragma HLS UNROLL
-                group_sums[g] = 0.0f;
-            }
-            
-            // Compute groups - pipeline only, avoid full unroll
-            compute_groups: for (int d = 0; d < dim; d++) {
-                #pragma HLS PIPELINE II=1
-                int group_idx = d % REDUCTION_GROUPS;  // Distribute across groups
-                // Use standard floating-point subtraction and multiplication
-                float diff = sumA[d] - sumB[d];
-                float square = diff * diff;
-                float temp_sum = group_sums[group_idx];
-                group_sums[group_idx] = temp_sum + square;
-            }
-            
-            // Accumulate groups - small enough to unroll
-            accumulate_groups: for (int g = 0; g < REDUCTION_GROUPS; g++) {
-                #pragma HLS UNROLL
-                float temp_distance = distance_squared;
-                distance_squared = temp_distance + group_sums[g];
-            }
-            
-            // Alternative: If REDUCTION_GROUPS is too large, use this instead:
-            // accumulate_groups_seq: for (int g = 0; g < REDUCTION_GROUPS; g++) {
-            //     #pragma HLS PIPELINE II=1
-            //     distance_squared += group_sums[g];
-            // }
-            
-            result_stream.write(distance_squared);
-        }
-    }
+    fitness_engine<max_capacity_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                             vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                             objective, emit_diff, prune_threshold, top_k, num_generations,
+                                             rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                             memo_lookups, memo_hits);
 }
 
 #ifdef __cplusplus
 }
-#endif
\ No newline at end of file
+#endif
@@ -3,26 +3,550 @@
 
 #include <hls_stream.h>
 #include <ap_int.h>
+#include <ap_fixed.h>
 
+// Capacity of the max-capacity variant, fitness_kernel. The other named
+// tops get their own fitness_config below.
 #define MAX_DIM 100
 #define MAX_GENES 1000
 #define BITS_PER_CHUNK 32
 #define PARTIAL_UNROLL 10
+#define MAX_BATS 128
+#define MAX_CHUNKS ((MAX_GENES + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK)
 
+// Bats evaluated per pass over the cache in MODE_COMPUTE. 1 selects the
+// sparse single-bat path; K > 1 broadcasts each cache read to K bats.
+#ifndef BAT_LANES
+#define BAT_LANES 4
+#endif
+
+// Partial-sum banks per accumulator. Consecutive genes go to different
+// banks round-robin, so a bank is revisited only every ACC_BANKS genes and
+// the float adder latency no longer limits the gene loop to II>1.
+#define ACC_BANKS 4
+
+// Accumulator and cache element type. Define FITNESS_ACC_FIXED for exact
+// fixed-point sums with single-cycle adders, e.g. on integer-coordinate
+// instances (ACC_INT_BITS == ACC_WIDTH is a plain ap_int<ACC_WIDTH>).
+#ifndef ACC_WIDTH
+#define ACC_WIDTH 48
+#endif
+#ifndef ACC_INT_BITS
+#define ACC_INT_BITS 48
+#endif
+
+#ifdef FITNESS_ACC_FIXED
+typedef ap_fixed<ACC_WIDTH, ACC_INT_BITS> acc_t;
+#else
+typedef float acc_t;
+#endif
+
+// Define FITNESS_ACC_COMPENSATED to keep the gene sums of MODE_COMPUTE /
+// MODE_RANDOM and the total vector as compensated float pairs (TwoSum), so
+// sumA - sumB is formed from sums with near-double accuracy instead of from
+// float sums that drift with the gene count. Same II, about four times the
+// adders in the accumulate stages. Float acc_t only.
+#if defined(FITNESS_ACC_COMPENSATED) && defined(FITNESS_ACC_FIXED)
+#error "FITNESS_ACC_COMPENSATED applies to the float accumulator only"
+#endif
+
+// Kernel modes (selected through the `mode` control register)
+#define MODE_COMPUTE 0      // full evaluation of num_bats chromosomes
+#define MODE_LOAD 1         // copy vectors_in into the on-chip cache
+#define MODE_INCREMENTAL 2  // apply per-bat flip lists to the resident sums
+#define MODE_LOAD_WIDE 3    // MODE_LOAD through the 512-bit vectors_wide port
+#define MODE_STREAM 4       // out-of-core: vectors stay in DDR, streamed in tiles
+#define MODE_BAT 5          // run num_generations of the binary bat algorithm on-chip
+#define MODE_RANDOM 6       // MODE_COMPUTE on num_bats chromosomes drawn from the RNG bank
+#define MODE_WALK 7         // MODE_INCREMENTAL with walk_flips random flips per bat
+#define MODE_SWAP 8         // make the shadow cache bank the active one (ping-pong variants)
+#define MODE_SCAN 9         // score every single-gene flip of num_bats chromosomes
+// Any other mode value reads and writes nothing (a ping-pong preload still runs)
+
+// Objectives (selected through the `objective` control register)
+#define OBJ_SUM_SQUARES 0   // sum_d (sumA_d - sumB_d)^2
+#define OBJ_MAX_ABS 1       // max_d |sumA_d - sumB_d|, the MDTWNPP objective
+#define OBJ_SUM_ABS 2       // sum_d |sumA_d - sumB_d|
+
+// With `emit_diff` set, every fitness value on result_stream is followed by
+// the dim entries of sumA - sumB and then the argmax |sumA_d - sumB_d| index.
+
+// Early-exit pruning (MODE_COMPUTE, OBJ_MAX_ABS, prune_threshold > 0): every
+// PRUNE_INTERVAL genes the kernel checks whether max_d |sumA_d - sumB_d| is
+// already bound to exceed the threshold, and if so stops accumulating that
+// bat and reports PRUNED_FITNESS in place of its fitness. A pruned bat keeps
+// its chromosome but no difference; the next MODE_INCREMENTAL call rebuilds
+// that from the chromosome before applying its flips.
+#define PRUNE_INTERVAL 64   // genes per checkpoint, a multiple of every variant's chunk width
+#define PRUNED_FITNESS -1.0f
+
+// With `top_k` = K > 0 the per-bat output (fitness and any emit_diff
+// trailer) is replaced by K (fitness, bat index as float) pairs, best
+// first, written after the last bat. Pruned bats are left out; unused
+// slots read (PRUNED_FITNESS, -1).
+#define TOPK_MAX 8
+
+// One-flip neighborhood scan (MODE_SCAN): per bat the stream carries one
+// chromosome. The kernel writes its fitness (plus any emit_diff trailer),
+// then the fitness of each of its chromo_len single-gene flips in gene
+// order, every one scored from sumA - sumB -/+ 2 v_gene in O(dim). With
+// top_k = K > 0 the flip list is replaced by that bat's K best flips as
+// (fitness, gene index as float) pairs, best first. Packed flip records
+// carry the gene index and the flipped chromosome's popcount. Chromosome and
+// sums stay resident, so MODE_INCREMENTAL can apply the chosen flip.
+
+// Out-of-core limits: the population (num_bats <= MAX_BATS) stays on-chip
+// while the instance is streamed from vectors_in OOC_TILE_GENES genes at a time.
+// Bats from MAX_BATS on, and every bat of an instance beyond OOC_MAX_GENES
+// genes or the variant's dimension limit, are read but report PRUNED_FITNESS.
+#define OOC_MAX_GENES 20480
+#define OOC_TILE_GENES 128
+
+// On-chip binary bat algorithm (MODE_BAT). The initial population of
+// num_bats chromosomes arrives on chromosome_stream; the first
+// ENGINE_MAX_BATS fly and any others are read and dropped. The kernel writes
+// the best chromosome to best_chromo_out and its fitness (plus the emit_diff
+// trailer) to result_stream. With num_bats == 0 that is an all-zero
+// chromosome and PRUNED_FITNESS.
+#define ENGINE_MAX_BATS 32
+#define BAT_VEL_FRAC_BITS 4     // velocity_t is fixed point with 4 fractional bits
+#define BAT_VMAX 4              // velocities are clamped to [-BAT_VMAX, BAT_VMAX]
+#define BAT_FMIN 0.0f
+#define BAT_FMAX 2.0f
+#define BAT_LOUDNESS0 1.0f
+#define BAT_ALPHA 0.9f          // loudness decay per accepted move
+#define BAT_PULSE0 0.5f
+#define BAT_GAMMA 0.9f          // pulse rate growth over generations
+typedef ap_int<8> velocity_t;
+
+// Ping-pong instance cache (variants with fitness_config::ping_pong): every
+// mode runs against the active bank. A nonzero preload_len makes any mode
+// other than the loads also copy a preload_len x preload_dim instance from
+// vectors_wide into the shadow bank while it runs; MODE_SWAP then activates
+// it without a reload gap. MODE_LOAD and MODE_LOAD_WIDE fill the shadow bank
+// and swap it in, unless chromo_len <= 0, which loads and swaps nothing.
+// Resident bat state belongs to the old instance after a swap, so
+// re-evaluate before MODE_INCREMENTAL. Single-bank variants load in place
+// and ignore preload_len; MODE_SWAP only returns its completion value.
+
+// Packed results (pack_results): per-bat fitness values and top-K entries
+// go to record_stream instead of result_stream, as 64-bit records of
+// fitness float bits [31:0], bat index [47:32] and chromosome popcount
+// [63:48]. RESULT_RECORDS records per 512-bit beat, record 0 in the low bits;
+// the last beat of a call is padded with records whose bat index is
+// RESULT_NO_BAT, as are empty top-K slots. emit_diff trailers, completion
+// values and the single MODE_BAT result stay on result_stream.
+#define RESULT_RECORDS 8
+#define RESULT_NO_BAT 0xFFFF
+typedef ap_uint<64 * RESULT_RECORDS> result_beat_t;
+
+// Wide chromosome input of fitness_kernel_wide_in: CHROMO_BEAT_CHUNKS
+// packed_t words per 256-bit beat, word 0 in the low bits. Each bat's record
+// (chromosome, or MODE_INCREMENTAL flip count plus indices) starts on a new
+// beat; the unused words of its last beat are ignored.
+#define CHROMO_BEAT_CHUNKS 8
+typedef ap_uint<32 * CHROMO_BEAT_CHUNKS> chromo_beat_t;
+
+// Command stream of the free-running fitness_server. Each packet is an
+// opcode word followed by its operand words (one packed_t each). CMD_SET_*
+// packets update the state that fitness_kernel takes from its registers;
+// CMD_RUN executes one mode with it, exactly as a fitness_kernel call would.
+// The seed and preload settings apply to the next CMD_RUN only.
+#define CMD_HALT 0          // leave the command loop
+#define CMD_RUN 1           // mode, num_bats
+#define CMD_SET_SHAPE 2     // chromo_len, dim
+#define CMD_SET_OBJECTIVE 3 // objective, emit_diff
+#define CMD_SET_THRESHOLD 4 // prune_threshold as float bits
+#define CMD_SET_TOP_K 5     // top_k
+#define CMD_SET_SEARCH 6    // num_generations, walk_flips
+#define CMD_SET_SEED 7      // rng_seed
+#define CMD_SET_PRELOAD 8   // preload_len, preload_dim
+#define CMD_SET_RECORDS 9   // pack_results
+
+// On-chip RNG bank: RNG_LANES xoshiro128** generators, expanded from the
+// rng_seed register with splitmix32. A nonzero rng_seed reseeds the bank,
+// zero continues the sequence. MODE_RANDOM and MODE_WALK also write the best
+// resulting chromosome (of bats below MAX_BATS) to best_chromo_out.
+#define RNG_LANES 4
+
+// One chromosome chunk: gene g in bit g % BITS_PER_CHUNK of chunk
+// g / BITS_PER_CHUNK. Bits of the last chunk past chromo_len may hold
+// anything; they are not genes and are never counted.
 typedef ap_uint<32> packed_t;
 
+// Duplicate filter (MODE_COMPUTE / MODE_RANDOM without pruning): the last
+// MEMO_ENTRIES distinct chromosomes and their sumA - sumB. A bat equal to one
+// of them skips accumulation; its fitness, trailer and resident difference
+// come from the stored difference, under the current objective. Loads, swaps
+// and a new chromo_len or dim clear it. The memo_lookups / memo_hits output
+// registers count the bats looked up and found since then.
+#define MEMO_ENTRIES 8
+
+// 512-bit beat of the wide cache loader: WIDE_FLOATS floats, element 0 in
+// the low bits. The cache is partitioned so a whole beat lands in one cycle.
+#define WIDE_FLOATS 16
+#define CACHE_BANKS WIDE_FLOATS
+typedef ap_uint<32 * WIDE_FLOATS> wide_t;
+
+// 16-bit cache storage formats (fitness_config's StoreT). A variant that
+// stores one of these keeps twice the elements in the same BRAM, widens them
+// to float on every cache read and still accumulates in acc_t, so only the
+// stored vectors are rounded. Its vectors_wide beats carry WIDE_HALVES raw
+// 16-bit values instead of WIDE_FLOATS floats; from_float() rounds to
+// nearest even and is what the host uses to pack them.
+#define WIDE_HALVES 32
+
+// bfloat16: the top half of an IEEE float (8-bit exponent, 7-bit mantissa)
+struct bf16_t {
+    ap_uint<16> bits;
+
+    static bf16_t from_float(float f) {
+        union { unsigned int u; float f; } word;
+        word.f = f;
+        unsigned int lsb = (word.u >> 16) & 1;
+        bf16_t out;
+        out.bits = (word.u + 0x7FFF + lsb) >> 16;
+        return out;
+    }
+
+    float to_float() const {
+        union { unsigned int u; float f; } word;
+        word.u = bits.to_uint() << 16;
+        return word.f;
+    }
+};
+
+// IEEE half (5-bit exponent, 10-bit mantissa). Overflow saturates to
+// infinity; values below the smallest subnormal flush to zero.
+struct fp16_t {
+    ap_uint<16> bits;
+
+    static fp16_t from_float(float f) {
+        union { unsigned int u; float f; } word;
+        word.f = f;
+        unsigned int sign = (word.u >> 16) & 0x8000;
+        int exp = (int)((word.u >> 23) & 0xFF) - 127 + 15;
+        unsigned int man = word.u & 0x7FFFFF;
+        unsigned int h;
+        if (exp >= 31) {
+            h = ((word.u >> 23) & 0xFF) == 0xFF && man ? 0x7E00 : 0x7C00;
+        } else if (exp <= 0) {
+            if (exp < -10) {
+                h = 0;
+            } else {
+                // Subnormal: shift the implicit bit into the 10-bit mantissa
+                man |= 0x800000;
+                int shift = 14 - exp;
+                h = man >> shift;
+                unsigned int rest = man & ((1u << shift) - 1);
+                unsigned int half_way = 1u << (shift - 1);
+                if (rest > half_way || (rest == half_way && (h & 1))) h++;
+            }
+        } else {
+            // Rounding carries into the exponent, up to infinity
+            h = ((unsigned int)exp << 10) | (man >> 13);
+            unsigned int rest = man & 0x1FFF;
+            if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) h++;
+        }
+        fp16_t out;
+        out.bits = sign | h;
+        return out;
+    }
+
+    float to_float() const {
+        unsigned int h = bits.to_uint();
+        unsigned int exp = (h >> 10) & 0x1F;
+        unsigned int man = h & 0x3FF;
+        union { unsigned int u; float f; } word;
+        if (exp == 0) {
+            // Zero or subnormal: man * 2^-24 is exact in float
+            word.f = (float)man * (1.0f / 16777216.0f);
+            word.u |= (h & 0x8000) << 16;
+        } else {
+            word.u = ((h & 0x8000) << 16) | ((exp == 31 ? 255 : exp + 112) << 23) | (man << 13);
+        }
+        return word.f;
+    }
+};
+
+// Memory the cache binds to. hls_config_uram.cfg defines FITNESS_CACHE_URAM
+// for fitness_top_uram: the cache is then reshaped into one 512-bit word per
+// vectors_wide beat instead of being partitioned into banks, and each word
+// spans eight 72-bit UltraRAM columns (two floats or four 16-bit values per
+// column). hls_config_small_dim.cfg defines FITNESS_CACHE_LUTRAM for
+// fitness_top: its dim-major cache reads a whole chunk of genes in every
+// dimension per cycle, 640 banks of 161 words, far more read ports than the
+// part's 624 BRAM18 can give, but each bank is only about 15 RAM64M8 slices
+// of LUTRAM. A pragma's impl= cannot follow a template parameter, hence a
+// build flag rather than a fitness_config field.
+#ifdef FITNESS_CACHE_URAM
+#define CACHE_IMPL uram
+#elif defined(FITNESS_CACHE_LUTRAM)
+#define CACHE_IMPL lutram
+#else
+#define CACHE_IMPL bram
+#endif
+
+// Compile-time shape of one kernel variant: cache capacity, how many
+// dimensions each gene step adds in parallel, chromosome chunk width,
+// accumulator type and cache layout. fitness_engine<C> (fitness_kernel_impl.h)
+// sizes and partitions all of its storage from these.
+//
+// DimMajor stores the cache transposed (one row per dimension) and evaluates
+// MODE_COMPUTE / MODE_RANDOM a whole chunk of genes per cycle through a
+// masked adder tree, instead of one selected gene per cycle. It suits many
+// genes over few dimensions: the cache is split into ChunkBits * MaxDim
+// banks, small enough for LUTRAM (FITNESS_CACHE_LUTRAM), and BAT_LANES does
+// not apply.
+//
+// StoreT is the cache element type: AccT itself, or bf16_t / fp16_t.
+//
+// PingPong adds a second cache bank (with its own total and bounds) for
+// preloading and MODE_SWAP. It doubles the cache, so it is only set where
+// both banks fit next to the rest of the kernel.
+template <int MaxDim, int MaxGenes, int Unroll, int ChunkBits, typename AccT, bool DimMajor = false,
+          typename StoreT = AccT, bool PingPong = false>
+struct fitness_config {
+    static const int max_dim = MaxDim;
+    static const int max_genes = MaxGenes;
+    static const int unroll = Unroll;
+    static const int chunk_bits = ChunkBits;
+    typedef AccT acc_t;
+    static const bool dim_major = DimMajor;
+    typedef StoreT store_t;
+    static const bool ping_pong = PingPong;
+};
+
+// Prebuilt variants, one synthesis target each (hls_config*.cfg). All keep
+// roughly the same cache footprint and trade dimensions against genes. One
+// BRAM cache bank is about 208 BRAM18 and the out-of-core and resident bat
+// state take about 330 more, so of the 624 on the xczu7ev there is no room
+// for a second bank; only the URAM variant is ping-pong.
+typedef fitness_config<MAX_DIM, MAX_GENES, PARTIAL_UNROLL, BITS_PER_CHUNK, acc_t> max_capacity_config;
+
+// fitness_top: dim <= 20, dim-major cache, whole vector added per chunk step
+#define SMALL_DIM_MAX_DIM 20
+#define SMALL_DIM_MAX_GENES 5000
+#define SMALL_DIM_UNROLL 20
+typedef fitness_config<SMALL_DIM_MAX_DIM, SMALL_DIM_MAX_GENES, SMALL_DIM_UNROLL, 32, acc_t, true> small_dim_config;
+
+// fitness_top_large_dim: up to 400 dimensions over at most 250 genes
+#define LARGE_DIM_MAX_DIM 400
+#define LARGE_DIM_MAX_GENES 250
+#define LARGE_DIM_UNROLL 20
+typedef fitness_config<LARGE_DIM_MAX_DIM, LARGE_DIM_MAX_GENES, LARGE_DIM_UNROLL, 32, acc_t> large_dim_config;
+
+// fitness_top_bf16 / fitness_top_fp16: the max-capacity shape with 16-bit
+// storage, so twice the genes fit in the same cache BRAM
+#define HALF_STORE_MAX_GENES (2 * MAX_GENES)
+typedef fitness_config<MAX_DIM, HALF_STORE_MAX_GENES, PARTIAL_UNROLL, BITS_PER_CHUNK, acc_t, false, bf16_t> bf16_config;
+typedef fitness_config<MAX_DIM, HALF_STORE_MAX_GENES, PARTIAL_UNROLL, BITS_PER_CHUNK, acc_t, false, fp16_t> fp16_config;
+
+// fitness_top_uram: ten times the genes over up to 64 dims, bf16 storage in
+// UltraRAM (FITNESS_CACHE_URAM), ping-pong. One bank is 20000 words of 512
+// bits, i.e. 5 x 8 URAM288 blocks; both banks take 80 of the 96 on the
+// xczu7ev. With dim a multiple of URAM_UNROLL a gene step reads within a
+// single word.
+#define URAM_MAX_DIM 64
+#define URAM_MAX_GENES 10000
+#define URAM_UNROLL 16
+typedef fitness_config<URAM_MAX_DIM, URAM_MAX_GENES, URAM_UNROLL, BITS_PER_CHUNK, acc_t, false, bf16_t, true> uram_config;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Max-capacity variant (max_capacity_config)
 void fitness_kernel(
     hls::stream<packed_t>& chromosome_stream,
     hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// Small-dim / large-n variant (small_dim_config)
+void fitness_top(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// Large-dim / small-n variant (large_dim_config)
+void fitness_top_large_dim(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// Max-capacity variant with a 256-bit chromosome stream
+void fitness_kernel_wide_in(
+    hls::stream<chromo_beat_t>& chromosome_beats,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// bfloat16-storage variant (bf16_config); vectors_wide carries bf16_t bits
+void fitness_top_bf16(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// fp16-storage variant (fp16_config); vectors_wide carries fp16_t bits
+void fitness_top_fp16(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
     const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
     int chromo_len,
     int dim,
     int num_bats,
-    bool mode
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// UltraRAM variant (uram_config, FITNESS_CACHE_URAM); vectors_wide carries bf16_t bits
+void fitness_top_uram(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+);
+
+// Free-running max-capacity variant driven by command_stream (CMD_*)
+void fitness_server(
+    hls::stream<packed_t>& command_stream,
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out
 );
 
 #ifdef __cplusplus
@@ -0,0 +1,2690 @@
+#ifndef FITNESS_KERNEL_IMPL_H
+#define FITNESS_KERNEL_IMPL_H
+
+#include <hls_stream.h>
+#include <ap_int.h>
+#include <hls_math.h>
+#include "fitness_kernel.h"
+
+// Unevaluated sum hi + lo of floats, kept by error-free transformations
+// (TwoSum): every addition also recovers its own rounding error and adds it
+// to lo. hi and lo each depend on their previous value through one add only,
+// so a loop that accumulates into a compensated sum keeps its II.
+template <typename T>
+struct compensated {
+    T hi;
+    T lo;
+
+    compensated() : hi(0), lo(0) {}
+    compensated(T x) : hi(x), lo(0) {}
+
+    compensated operator-() const {
+        #pragma HLS INLINE
+        compensated r;
+        r.hi = -hi;
+        r.lo = -lo;
+        return r;
+    }
+
+    friend compensated operator+(const compensated& a, const compensated& b) {
+        #pragma HLS INLINE
+        compensated r;
+        r.hi = a.hi + b.hi;
+        T b_virtual = r.hi - a.hi;
+        T a_virtual = r.hi - b_virtual;
+        T err = (a.hi - a_virtual) + (b.hi - b_virtual);
+        r.lo = a.lo + (b.lo + err);
+        return r;
+    }
+
+    friend compensated operator-(const compensated& a, const compensated& b) {
+        #pragma HLS INLINE
+        return a + (-b);
+    }
+};
+
+// Conversions between a cache element S and the accumulator A: storing a
+// float from vectors_in, unpacking one value of a vectors_wide beat, and
+// widening on read. The primary template stores A itself.
+template <typename S, typename A>
+struct cache_store {
+    static const int wire_bits = 32;
+    static const int wire_values = WIDE_FLOATS;
+
+    static S narrow(float f) {
+        #pragma HLS INLINE
+        return S(f);
+    }
+
+    static S from_wire(ap_uint<wire_bits> w) {
+        #pragma HLS INLINE
+        union { unsigned int u; float f; } word;
+        word.u = w.to_uint();
+        return S(word.f);
+    }
+
+    static A widen(const S& x) {
+        #pragma HLS INLINE
+        return x;
+    }
+};
+
+template <typename A>
+struct cache_store<bf16_t, A> {
+    static const int wire_bits = 16;
+    static const int wire_values = WIDE_HALVES;
+
+    static bf16_t narrow(float f) {
+        #pragma HLS INLINE
+        return bf16_t::from_float(f);
+    }
+
+    static bf16_t from_wire(ap_uint<wire_bits> w) {
+        #pragma HLS INLINE
+        bf16_t x;
+        x.bits = w;
+        return x;
+    }
+
+    static A widen(const bf16_t& x) {
+        #pragma HLS INLINE
+        return A(x.to_float());
+    }
+};
+
+template <typename A>
+struct cache_store<fp16_t, A> {
+    static const int wire_bits = 16;
+    static const int wire_values = WIDE_HALVES;
+
+    static fp16_t narrow(float f) {
+        #pragma HLS INLINE
+        return fp16_t::from_float(f);
+    }
+
+    static fp16_t from_wire(ap_uint<wire_bits> w) {
+        #pragma HLS INLINE
+        fp16_t x;
+        x.bits = w;
+        return x;
+    }
+
+    static A widen(const fp16_t& x) {
+        #pragma HLS INLINE
+        return A(x.to_float());
+    }
+};
+
+// Kernel body shared by the named tops, parameterized on a fitness_config.
+// Only the extern "C" wrappers (fitness_kernel.cpp, fitness_kernel_top.cpp)
+// carry INTERFACE pragmas; each instantiation owns its own cache.
+template <typename C>
+class fitness_engine {
+    typedef typename C::acc_t acc_t;
+    typedef typename C::store_t store_t;
+    typedef cache_store<store_t, acc_t> store;
+
+    // Gene sums (side sums, their banks and the total vector)
+#ifdef FITNESS_ACC_COMPENSATED
+    typedef compensated<acc_t> sum_t;
+#else
+    typedef acc_t sum_t;
+#endif
+    typedef ap_uint<C::chunk_bits> chunk_t;
+
+    static const int max_dim = C::max_dim;
+    static const int max_genes = C::max_genes;
+    static const int unroll = C::unroll;
+    static const int chunk_bits = C::chunk_bits;
+    static const int max_chunks = (max_genes + chunk_bits - 1) / chunk_bits;
+    static const int prune_segments = (max_genes + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL;
+    static const int ooc_max_chunks = (OOC_MAX_GENES + chunk_bits - 1) / chunk_bits;
+
+    // Lane-interleaved chunk: chunk c of every lane in a group, lane 0 in the low bits
+    typedef ap_uint<chunk_bits * BAT_LANES> lane_chunk_t;
+
+    // Cache layout. Gene-major keeps gene g's vector at g * dim. Dim-major
+    // keeps dimension d of every gene in row d, with the row stride padded to
+    // chunk_bits modulo chunk_bits * max_dim so that one chunk of genes in
+    // every dimension falls in distinct banks of the cyclic partition.
+    static const bool dim_major = C::dim_major;
+    static const int dim_banks = chunk_bits * max_dim;
+    static const int cache_stride = (max_genes - chunk_bits + dim_banks - 1) / dim_banks * dim_banks + chunk_bits;
+    static const int cache_size = dim_major ? max_dim * cache_stride : max_genes * max_dim;
+    static const int wire_bits = store::wire_bits;
+    static const int wire_values = store::wire_values;
+    static const int cache_banks = dim_major ? dim_banks : wire_values;
+
+    // Ping-pong variants keep a shadow copy of the cache; the others keep one
+    // copy, which is then both the active and the shadow bank
+    static const bool ping_pong = C::ping_pong;
+    static const int cache_copies = ping_pong ? 2 : 1;
+    static const int shadow_copy = cache_copies - 1;
+
+    static int cache_index(int gene_idx, int d, int dim) {
+        #pragma HLS INLINE
+        return dim_major ? d * cache_stride + gene_idx : gene_idx * dim + d;
+    }
+
+    // Step (gene, d) to the next element of vectors_in (gene-major, as the
+    // host lays it out). The load loops track the dim-major slot this way
+    // instead of dividing each element index by dim.
+    static void next_element(int& gene_idx, int& d, int dim) {
+        #pragma HLS INLINE
+        if (d == dim - 1) {
+            d = 0;
+            gene_idx++;
+        } else {
+            d++;
+        }
+    }
+
+    // Number of set bits in a chunk (adder tree after unrolling)
+    static int popcount_chunk(chunk_t x) {
+        #pragma HLS INLINE
+        int count = 0;
+        popcount_bits: for (int b = 0; b < chunk_bits; b++) {
+            #pragma HLS UNROLL
+            count += x[b] ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Chunk `chunk_idx` with the padding bits at and past chromo_len cleared.
+    // Hosts need not zero the padding, so every gene count goes through this.
+    static chunk_t valid_genes(chunk_t genes, int chunk_idx, int chromo_len) {
+        #pragma HLS INLINE
+        int valid_bits = chromo_len - chunk_idx * chunk_bits;
+        if (valid_bits < chunk_bits) {
+            genes &= (chunk_t(1) << valid_bits) - 1;
+        }
+        return genes;
+    }
+
+    // Set genes of chunk `chunk_idx`, padding excluded
+    static int count_genes(chunk_t genes, int chunk_idx, int chromo_len) {
+        #pragma HLS INLINE
+        return popcount_chunk(valid_genes(genes, chunk_idx, chromo_len));
+    }
+
+    // Index of the lowest set bit (priority encoder); x must be non-zero
+    static int lowest_set_bit(chunk_t x) {
+        #pragma HLS INLINE
+        int idx = 0;
+        priority_bits: for (int b = chunk_bits - 1; b >= 0; b--) {
+            #pragma HLS UNROLL
+            if (x[b]) idx = b;
+        }
+        return idx;
+    }
+
+    // Genes of chunk `chunk_idx` whose bit equals `side`, padding bits cleared
+    static chunk_t select_side(chunk_t genes, bool side, int chunk_idx, int chromo_len) {
+        #pragma HLS INLINE
+        return valid_genes(side ? genes : chunk_t(~genes), chunk_idx, chromo_len);
+    }
+
+    // A gene sum rounded to acc_t
+    static acc_t sum_value(const acc_t& x) {
+        #pragma HLS INLINE
+        return x;
+    }
+
+    static acc_t sum_value(const compensated<acc_t>& x) {
+        #pragma HLS INLINE
+        return x.hi + x.lo;
+    }
+
+    // Reinterpret a 32-bit word as the IEEE float it carries
+    static float bits_to_float(ap_uint<32> bits) {
+        #pragma HLS INLINE
+        union {
+            unsigned int u;
+            float f;
+        } word;
+        word.u = bits.to_uint();
+        return word.f;
+    }
+
+    // --- Reduce sumA - sumB to the selected objective ---
+    // diff_vec[d] holds sumA[d] - sumB[d]; the reduction itself runs in float.
+    // Squared-L2, L1 and L-infinity are all formed in the same pass and
+    // `objective` picks the one returned.
+    static float compute_objective(
+        const acc_t diff_vec[max_dim],
+        int dim,
+        int objective
+    ) {
+        #pragma HLS INLINE
+        float distance_squared = 0.0f;
+        float distance_abs = 0.0f;
+        float max_abs = 0.0f;
+
+        // Use hierarchical reduction to avoid large unrolls
+        const int REDUCTION_GROUPS = 4;  // Adjust based on your needs
+        float group_sums[REDUCTION_GROUPS];
+        float group_abs[REDUCTION_GROUPS];
+        #pragma HLS ARRAY_PARTITION variable=group_sums complete
+        #pragma HLS ARRAY_PARTITION variable=group_abs complete
+
+        // Initialize group sums
+        init_groups: for (int g = 0; g < REDUCTION_GROUPS; g++) {
+            #pragma HLS UNROLL
+            group_sums[g] = 0.0f;
+            group_abs[g] = 0.0f;
+        }
+
+        // Compute groups - pipeline only, avoid full unroll
+        compute_groups: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            int group_idx = d % REDUCTION_GROUPS;  // Distribute across groups
+            // Use standard floating-point subtraction and multiplication
+            float diff = static_cast<float>(diff_vec[d]);
+            float magnitude = hls::fabs(diff);
+            float square = diff * diff;
+            float temp_sum = group_sums[group_idx];
+            group_sums[group_idx] = temp_sum + square;
+            float temp_abs = group_abs[group_idx];
+            group_abs[group_idx] = temp_abs + magnitude;
+            if (magnitude > max_abs) max_abs = magnitude;
+        }
+
+        // Accumulate groups - small enough to unroll
+        accumulate_groups: for (int g = 0; g < REDUCTION_GROUPS; g++) {
+            #pragma HLS UNROLL
+            float temp_distance = distance_squared;
+            distance_squared = temp_distance + group_sums[g];
+            float temp_abs = distance_abs;
+            distance_abs = temp_abs + group_abs[g];
+        }
+
+        // Alternative: If REDUCTION_GROUPS is too large, use this instead:
+        // accumulate_groups_seq: for (int g = 0; g < REDUCTION_GROUPS; g++) {
+        //     #pragma HLS PIPELINE II=1
+        //     distance_squared += group_sums[g];
+        // }
+
+        if (objective == OBJ_MAX_ABS) return max_abs;
+        if (objective == OBJ_SUM_ABS) return distance_abs;
+        return distance_squared;
+    }
+
+    // Optional trailer after a fitness value: the dim entries of sumA - sumB
+    // followed by the index of the entry with the largest magnitude
+    static void emit_difference(
+        hls::stream<float>& result_stream,
+        const acc_t diff_vec[max_dim],
+        int dim
+    ) {
+        #pragma HLS INLINE
+        float max_abs = -1.0f;
+        int argmax = 0;
+
+        emit_diff_dims: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            float diff = static_cast<float>(diff_vec[d]);
+            float magnitude = hls::fabs(diff);
+            if (magnitude > max_abs) {
+                max_abs = magnitude;
+                argmax = d;
+            }
+            result_stream.write(diff);
+        }
+
+        result_stream.write(static_cast<float>(argmax));
+    }
+
+    // Top-K register file: slots [0, k) sorted ascending by fitness (lower is
+    // better), best_bat < 0 marks an empty slot. best_ones carries each
+    // entry's popcount for packed records.
+    static void topk_reset(float best_fitness[TOPK_MAX], int best_bat[TOPK_MAX], int best_ones[TOPK_MAX]) {
+        #pragma HLS INLINE
+        for (int i = 0; i < TOPK_MAX; i++) {
+            #pragma HLS UNROLL
+            best_fitness[i] = PRUNED_FITNESS;
+            best_bat[i] = -1;
+            best_ones[i] = 0;
+        }
+    }
+
+    // One-cycle insertion: every slot the new value beats takes its upper
+    // neighbour (or the new value), walking down so reads see the old contents.
+    // Ties keep the earlier bat.
+    static void topk_insert(
+        float best_fitness[TOPK_MAX],
+        int best_bat[TOPK_MAX],
+        int best_ones[TOPK_MAX],
+        float fitness,
+        int bat,
+        int ones,
+        int k
+    ) {
+        #pragma HLS INLINE
+        for (int i = TOPK_MAX - 1; i >= 0; i--) {
+            #pragma HLS UNROLL
+            bool beats_slot = best_bat[i] < 0 || fitness < best_fitness[i];
+            bool beats_upper = i > 0 && (best_bat[i - 1] < 0 || fitness < best_fitness[i - 1]);
+            if (i < k && beats_slot) {
+                best_fitness[i] = beats_upper ? best_fitness[i - 1] : fitness;
+                best_bat[i] = beats_upper ? best_bat[i - 1] : bat;
+                best_ones[i] = beats_upper ? best_ones[i - 1] : ones;
+            }
+        }
+    }
+
+    // K (fitness, bat index as float) pairs, best first; empty slots read
+    // (PRUNED_FITNESS, -1). Packed, one record per slot.
+    static void topk_emit(
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        result_beat_t& beat,
+        int& fill,
+        bool pack_results,
+        const float best_fitness[TOPK_MAX],
+        const int best_bat[TOPK_MAX],
+        const int best_ones[TOPK_MAX],
+        int k
+    ) {
+        #pragma HLS INLINE
+        emit_topk: for (int i = 0; i < k; i++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=TOPK_MAX
+            #pragma HLS PIPELINE II=1
+            if (pack_results) {
+                record_put(record_stream, beat, fill, best_fitness[i], best_bat[i], best_ones[i]);
+            } else {
+                result_stream.write(best_fitness[i]);
+                result_stream.write(static_cast<float>(best_bat[i]));
+            }
+        }
+    }
+
+    // Result records: fitness bits, bat index and popcount gathered
+    // RESULT_RECORDS to a beat. A beat goes out as soon as it is full;
+    // record_flush pads and sends the last one of a call. A negative bat
+    // (empty top-K slot) is stored as RESULT_NO_BAT.
+    static void record_put(
+        hls::stream<result_beat_t>& record_stream,
+        result_beat_t& beat,
+        int& fill,
+        float fitness,
+        int bat,
+        int ones
+    ) {
+        #pragma HLS INLINE
+        union {
+            float f;
+            unsigned int u;
+        } word;
+        word.f = fitness;
+        ap_uint<64> record = 0;
+        record.range(31, 0) = word.u;
+        record.range(47, 32) = bat < 0 ? RESULT_NO_BAT : bat;
+        record.range(63, 48) = ones;
+        beat.range(64 * fill + 63, 64 * fill) = record;
+        if (fill == RESULT_RECORDS - 1) {
+            record_stream.write(beat);
+            fill = 0;
+        } else {
+            fill++;
+        }
+    }
+
+    static void record_flush(hls::stream<result_beat_t>& record_stream, result_beat_t& beat, int& fill) {
+        #pragma HLS INLINE
+        if (fill == 0) return;
+        pad_records: for (int i = fill; i < RESULT_RECORDS; i++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=RESULT_RECORDS-1
+            #pragma HLS PIPELINE II=1
+            beat.range(64 * i + 63, 64 * i) = ap_uint<64>(RESULT_NO_BAT) << 32;
+        }
+        record_stream.write(beat);
+        fill = 0;
+    }
+
+    // --- RNG BANK ---
+    // RNG_LANES xoshiro128** generators. Consumers draw from the lanes
+    // round-robin, so a lane's state update has RNG_LANES cycles of slack and
+    // the bank as a whole can deliver RNG_LANES words per cycle.
+
+    static unsigned int rotl32(unsigned int x, int k) {
+        #pragma HLS INLINE
+        return (x << k) | (x >> (32 - k));
+    }
+
+    static unsigned int rng_next(unsigned int s[4]) {
+        #pragma HLS INLINE
+        const unsigned int result = rotl32(s[1] * 5, 7) * 9;
+        const unsigned int t = s[1] << 9;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl32(s[3], 11);
+        return result;
+    }
+
+    // Expand one 32-bit seed into every lane's state with splitmix32
+    static void rng_seed_bank(unsigned int rng_state[RNG_LANES][4], unsigned int seed) {
+        #pragma HLS INLINE
+        unsigned int x = seed;
+        seed_lanes: for (int i = 0; i < RNG_LANES * 4; i++) {
+            #pragma HLS PIPELINE II=1
+            x += 0x9E3779B9u;
+            unsigned int z = x;
+            z = (z ^ (z >> 16)) * 0x85EBCA6Bu;
+            z = (z ^ (z >> 13)) * 0xC2B2AE35u;
+            rng_state[i / 4][i % 4] = z ^ (z >> 16);
+        }
+    }
+
+    // Uniform in [0, 1) from the top 24 bits
+    static float uniform(unsigned int s[4]) {
+        #pragma HLS INLINE
+        return static_cast<float>(rng_next(s) >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform gene index in [0, chromo_len)
+    static int random_gene(unsigned int s[4], int chromo_len) {
+        #pragma HLS INLINE
+        return static_cast<int>((static_cast<unsigned long long>(rng_next(s)) * chromo_len) >> 32);
+    }
+
+    // Random chunk `chunk_idx` of a chromosome, padding bits cleared like a
+    // host-built one; wider chunks take one word from each following lane
+    static chunk_t random_chunk(unsigned int rng_state[RNG_LANES][4], int chunk_idx, int chromo_len) {
+        #pragma HLS INLINE
+        const int words = (chunk_bits + 31) / 32;
+        chunk_t genes = 0;
+        for (int w = 0; w < words; w++) {
+            #pragma HLS UNROLL
+            ap_uint<32> word = rng_next(rng_state[(chunk_idx * words + w) % RNG_LANES]);
+            for (int b = 0; b < 32 && w * 32 + b < chunk_bits; b++) {
+                #pragma HLS UNROLL
+                genes[w * 32 + b] = word[b];
+            }
+        }
+        return valid_genes(genes, chunk_idx, chromo_len);
+    }
+
+    // --- COMPUTE PATH: DATAFLOW STAGES ---
+    // read -> accumulate -> reduce, each looping over all bats and connected by
+    // FIFOs, so reading bat i+1 and reducing bat i-1 overlap with accumulating
+    // bat i. The accumulate stage hands over the merged sum of the side it
+    // accumulated; the reduce stage turns it into sumA - sumB.
+
+    // L-infinity lower bound after the genes before a checkpoint: the final
+    // |sumA_d - sumB_d| is at least |partial_d| minus the remaining genes'
+    // absolute mass in d. True when some dimension already exceeds `limit`.
+    static bool exceeds_bound(
+        const sum_t side_sum[ACC_BANKS][max_dim],
+        bool side,
+        const acc_t prefix_total[max_dim],
+        const acc_t suffix_abs[max_dim],
+        int dim,
+        float limit
+    ) {
+        #pragma HLS INLINE
+        bool hopeless = false;
+
+        bound_dims: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            sum_t merged = side_sum[0][d];
+            for (int b = 1; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                merged = merged + side_sum[b][d];
+            }
+            sum_t twice_sum = merged + merged;
+            acc_t partial = sum_value(side ? sum_t(prefix_total[d] - twice_sum) : sum_t(twice_sum - prefix_total[d]));
+            acc_t magnitude = partial < acc_t(0) ? acc_t(-partial) : partial;
+            if (static_cast<float>(magnitude - suffix_abs[d]) > limit) hopeless = true;
+        }
+
+        return hopeless;
+    }
+
+    // --- DUPLICATE FILTER ---
+    // Stage 1 compares each incoming chromosome against all MEMO_ENTRIES
+    // stored ones while it streams in, so the verdict is ready with the last
+    // chunk. The verdict travels with the bat through stage 2 (a hit skips
+    // accumulation like a pruned bat) to reduce_bats, which keeps the
+    // difference of every stored chromosome.
+    static const int memo_off = -1;     // verdict with the filter disabled
+    static const int count_lookups = 0; // memo_count[]: bats looked up, bats found
+    static const int count_hits = 1;
+
+    static bool memo_hit(int verdict) {
+        #pragma HLS INLINE
+        return verdict >= MEMO_ENTRIES;
+    }
+
+    // Hit: MEMO_ENTRIES + matching entry. Miss: the entry to refill, taken
+    // round-robin by the miss count, which is marked valid here; the caller
+    // writes its key while forwarding the chunks.
+    static int memo_verdict(
+        const bool match[MEMO_ENTRIES],
+        bool memo_valid[MEMO_ENTRIES],
+        unsigned int memo_count[2],
+        bool memoize
+    ) {
+        #pragma HLS INLINE
+        if (!memoize) return memo_off;
+
+        int verdict = (memo_count[count_lookups] - memo_count[count_hits]) % MEMO_ENTRIES;
+        match_entries: for (int e = 0; e < MEMO_ENTRIES; e++) {
+            #pragma HLS UNROLL
+            if (match[e]) verdict = MEMO_ENTRIES + e;
+        }
+        memo_count[count_lookups]++;
+        if (memo_hit(verdict)) memo_count[count_hits]++;
+        else memo_valid[verdict] = true;
+        return verdict;
+    }
+
+    // Stage 1 (sparse): buffer one chromosome (from the stream, or drawn from
+    // the RNG bank), count its set bits in total and per pruning segment,
+    // look it up in the duplicate filter, forward it
+    static void read_sparse(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<chunk_t>& chunk_fifo,
+        hls::stream<int>& ones_fifo,
+        hls::stream<int>& memo_fifo,
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        unsigned int memo_count[2],
+        bool memoize,
+        bool generate,
+        int chromo_len,
+        int num_bats
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const int num_segments = (chromo_len + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL;
+        const int chunks_per_segment = PRUNE_INTERVAL / chunk_bits;
+
+        chunk_t chromo_buffer[max_chunks];
+        int segment_ones[prune_segments];
+        bool match[MEMO_ENTRIES];
+        #pragma HLS ARRAY_PARTITION variable=match complete
+
+        read_batches: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
+
+            int ones = 0;
+            for (int e = 0; e < MEMO_ENTRIES; e++) {
+                #pragma HLS UNROLL
+                match[e] = memo_valid[e];
+            }
+            read_chromosomes: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                #pragma HLS PIPELINE II=1
+                #pragma HLS DEPENDENCE variable=rng_state inter distance=RNG_LANES true
+                chunk_t genes = generate ? random_chunk(rng_state, chunk, chromo_len) : chromosome_stream.read();
+                chromo_buffer[chunk] = genes;
+                int chunk_ones = count_genes(genes, chunk, chromo_len);
+                ones += chunk_ones;
+                int segment = chunk / chunks_per_segment;
+                segment_ones[segment] = (chunk % chunks_per_segment == 0) ? chunk_ones
+                                                                          : segment_ones[segment] + chunk_ones;
+                // Keep the chromosome resident for later MODE_INCREMENTAL calls
+                if (bat < MAX_BATS) bat_chromo[bat][chunk] = genes;
+                memo_compare: for (int e = 0; e < MEMO_ENTRIES; e++) {
+                    #pragma HLS UNROLL
+                    if (memo_key[e][chunk] != genes) match[e] = false;
+                }
+            }
+
+            if (bat < MAX_BATS) bat_ones[bat] = ones;
+            const int verdict = memo_verdict(match, memo_valid, memo_count, memoize);
+            memo_fifo.write(verdict);
+            ones_fifo.write(ones);
+            forward_segment_ones: for (int seg = 0; seg < num_segments; seg++) {
+                #pragma HLS PIPELINE II=1
+                ones_fifo.write(segment_ones[seg]);
+            }
+
+            forward_chunks: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                #pragma HLS PIPELINE II=1
+                chunk_fifo.write(chromo_buffer[chunk]);
+                if (verdict >= 0 && !memo_hit(verdict)) memo_key[verdict][chunk] = chromo_buffer[chunk];
+            }
+        }
+    }
+
+    // Stage 2 (sparse): one bat at a time, visiting only the genes of the
+    // minority side. With prune_limit > 0 the L-infinity bound is checked after
+    // every PRUNE_INTERVAL genes and a hopeless bat skips its remaining genes;
+    // a duplicate-filter hit skips all of them.
+    static void accumulate_sparse(
+        hls::stream<chunk_t>& chunk_fifo,
+        hls::stream<int>& ones_fifo,
+        hls::stream<int>& memo_fifo,
+        hls::stream<sum_t>& sum_fifo,
+        hls::stream<int>& card_fifo,
+        hls::stream<bool>& pruned_fifo,
+        hls::stream<int>& verdict_fifo,
+        const store_t local_vector_cache[cache_size],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        float prune_limit
+    ) {
+        // Single accumulator for the minority side of the partition, split
+        // into ACC_BANKS round-robin partial sums
+        sum_t side_sum[ACC_BANKS][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=side_sum complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=side_sum cyclic factor=unroll dim=2
+
+        const int num_segments = (chromo_len + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL;
+
+        // Initialize sums; afterwards emit_sums clears them for the next bat
+        init_sums: for (int i = 0; i < max_dim; i++) {
+            #pragma HLS PIPELINE II=1
+            for (int b = 0; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                side_sum[b][i] = 0;
+            }
+        }
+
+        accumulate_batches: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
+
+            // Accumulate whichever side has fewer genes (1 = group B)
+            const int verdict = memo_fifo.read();
+            const bool hit = memo_hit(verdict);
+            const int ones = ones_fifo.read();
+            const bool side = ones <= chromo_len - ones;
+
+            int chunk_idx = -1;
+            int bank = 0;
+            bool pruned = false;
+
+            process_segments: for (int seg = 0; seg < num_segments; seg++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=prune_segments
+
+                int seg_genes = chromo_len - seg * PRUNE_INTERVAL;
+                if (seg_genes > PRUNE_INTERVAL) seg_genes = PRUNE_INTERVAL;
+                const int seg_chunks = (seg_genes + chunk_bits - 1) / chunk_bits;
+                const int seg_ones = ones_fifo.read();
+                const int seg_side_genes = side ? seg_ones : seg_genes - seg_ones;
+
+                if (pruned || hit) {
+                    skip_chunks: for (int c = 0; c < seg_chunks; c++) {
+                        #pragma HLS PIPELINE II=1
+                        chunk_fifo.read();
+                    }
+                    chunk_idx += seg_chunks;
+                    continue;
+                }
+
+                // Visit only the selected genes: each step either pulls the next
+                // chunk's selection mask or consumes its lowest set bit, so the
+                // trip count is exactly seg_chunks + seg_side_genes.
+                chunk_t pending = 0;
+                process_genes: for (int step = 0; step < seg_chunks + seg_side_genes; step++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=PRUNE_INTERVAL/chunk_bits+PRUNE_INTERVAL/2
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=side_sum inter distance=ACC_BANKS true
+
+                    if (pending == 0) {
+                        chunk_idx++;
+                        pending = select_side(chunk_fifo.read(), side, chunk_idx, chromo_len);
+                    } else {
+                        int bit_idx = lowest_set_bit(pending);
+                        pending &= pending - 1;
+                        int gene_idx = chunk_idx * chunk_bits + bit_idx;
+
+                        // Process dimensions with partial unroll - NO PIPELINE pragma inside
+                        process_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                            int d_end = d_block + unroll;
+                            if (d_end > dim) d_end = dim;
+
+                            for (int d = d_block; d < d_end; d++) {
+                                #pragma HLS UNROLL
+                                sum_t temp_sum = side_sum[bank][d];
+                                side_sum[bank][d] = temp_sum + store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                            }
+                        }
+
+                        bank = (bank == ACC_BANKS - 1) ? 0 : bank + 1;
+                    }
+                }
+
+                if (prune_limit > 0.0f && seg + 1 < num_segments) {
+                    pruned = exceeds_bound(side_sum, side, prefix_total[seg + 1], suffix_abs[seg + 1],
+                                           dim, prune_limit);
+                }
+            }
+
+            card_fifo.write(ones);
+            pruned_fifo.write(pruned);
+            verdict_fifo.write(verdict);
+
+            // Merge the partial-sum banks and hand them to the reduce stage
+            emit_sums: for (int d = 0; d < dim; d++) {
+                #pragma HLS PIPELINE II=1
+                sum_t merged = side_sum[0][d];
+                merge_banks: for (int b = 1; b < ACC_BANKS; b++) {
+                    #pragma HLS UNROLL
+                    merged = merged + side_sum[b][d];
+                }
+                sum_fifo.write(merged);
+
+                for (int b = 0; b < ACC_BANKS; b++) {
+                    #pragma HLS UNROLL
+                    side_sum[b][d] = 0;
+                }
+            }
+        }
+    }
+
+    // Stage 2 (dim-major cache): a whole chunk per cycle. Each dimension row
+    // holds chunk_bits neighbouring genes in distinct banks, so the selected
+    // genes of the chunk are summed by a masked adder tree and added to the
+    // bank's partial sum once. Pruning and filter hits work as in
+    // accumulate_sparse.
+    static void accumulate_transposed(
+        hls::stream<chunk_t>& chunk_fifo,
+        hls::stream<int>& ones_fifo,
+        hls::stream<int>& memo_fifo,
+        hls::stream<sum_t>& sum_fifo,
+        hls::stream<int>& card_fifo,
+        hls::stream<bool>& pruned_fifo,
+        hls::stream<int>& verdict_fifo,
+        const store_t local_vector_cache[cache_size],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        float prune_limit
+    ) {
+        sum_t side_sum[ACC_BANKS][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=side_sum complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=side_sum cyclic factor=unroll dim=2
+
+        const int num_segments = (chromo_len + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL;
+
+        init_sums: for (int i = 0; i < max_dim; i++) {
+            #pragma HLS PIPELINE II=1
+            for (int b = 0; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                side_sum[b][i] = 0;
+            }
+        }
+
+        accumulate_batches: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
+
+            const int verdict = memo_fifo.read();
+            const bool hit = memo_hit(verdict);
+            const int ones = ones_fifo.read();
+            const bool side = ones <= chromo_len - ones;
+
+            int chunk_idx = 0;
+            bool pruned = false;
+
+            process_segments: for (int seg = 0; seg < num_segments; seg++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=prune_segments
+
+                int seg_genes = chromo_len - seg * PRUNE_INTERVAL;
+                if (seg_genes > PRUNE_INTERVAL) seg_genes = PRUNE_INTERVAL;
+                const int seg_chunks = (seg_genes + chunk_bits - 1) / chunk_bits;
+                // Per-segment counts only matter to the sparse gene walk
+                ones_fifo.read();
+
+                process_chunks: for (int c = 0; c < seg_chunks; c++, chunk_idx++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=PRUNE_INTERVAL/chunk_bits
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=side_sum inter distance=ACC_BANKS true
+
+                    const chunk_t genes = chunk_fifo.read();
+                    if (pruned || hit) continue;
+
+                    const chunk_t mask = select_side(genes, side, chunk_idx, chromo_len);
+                    const int gene_base = chunk_idx * chunk_bits;
+                    const int bank = chunk_idx % ACC_BANKS;
+
+                    process_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                        int d_end = d_block + unroll;
+                        if (d_end > dim) d_end = dim;
+
+                        for (int d = d_block; d < d_end; d++) {
+                            #pragma HLS UNROLL
+                            acc_t terms[chunk_bits];
+                            #pragma HLS ARRAY_PARTITION variable=terms complete
+                            mask_genes: for (int b = 0; b < chunk_bits; b++) {
+                                #pragma HLS UNROLL
+                                terms[b] = mask[b] ? store::widen(local_vector_cache[cache_index(gene_base + b, d, dim)]) : acc_t(0);
+                            }
+                            adder_tree: for (int width = chunk_bits / 2; width > 0; width /= 2) {
+                                #pragma HLS UNROLL
+                                for (int b = 0; b < width; b++) {
+                                    #pragma HLS UNROLL
+                                    terms[b] = terms[b] + terms[b + width];
+                                }
+                            }
+                            sum_t temp_sum = side_sum[bank][d];
+                            side_sum[bank][d] = temp_sum + terms[0];
+                        }
+                    }
+                }
+
+                if (!pruned && prune_limit > 0.0f && seg + 1 < num_segments) {
+                    pruned = exceeds_bound(side_sum, side, prefix_total[seg + 1], suffix_abs[seg + 1],
+                                           dim, prune_limit);
+                }
+            }
+
+            card_fifo.write(ones);
+            pruned_fifo.write(pruned);
+            verdict_fifo.write(verdict);
+
+            emit_sums: for (int d = 0; d < dim; d++) {
+                #pragma HLS PIPELINE II=1
+                sum_t merged = side_sum[0][d];
+                merge_banks: for (int b = 1; b < ACC_BANKS; b++) {
+                    #pragma HLS UNROLL
+                    merged = merged + side_sum[b][d];
+                }
+                sum_fifo.write(merged);
+
+                for (int b = 0; b < ACC_BANKS; b++) {
+                    #pragma HLS UNROLL
+                    side_sum[b][d] = 0;
+                }
+            }
+        }
+    }
+
+    // Stage 1 (lanes): buffer BAT_LANES chromosomes and forward them
+    // chunk-interleaved; lanes past num_bats are all-zero
+    static void read_lanes(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<lane_chunk_t>& chunk_fifo,
+        hls::stream<int>& ones_fifo,
+        hls::stream<int>& memo_fifo,
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        unsigned int memo_count[2],
+        bool memoize,
+        bool generate,
+        int chromo_len,
+        int num_bats
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+
+        chunk_t lane_chromo[BAT_LANES][max_chunks];
+        int lane_verdict[BAT_LANES];
+        bool match[MEMO_ENTRIES];
+        bool refilled[MEMO_ENTRIES];
+        #pragma HLS ARRAY_PARTITION variable=lane_chromo complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=lane_verdict complete
+        #pragma HLS ARRAY_PARTITION variable=match complete
+        #pragma HLS ARRAY_PARTITION variable=refilled complete
+
+        read_lane_groups: for (int group = 0; group < num_bats; group += BAT_LANES) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000/BAT_LANES
+
+            for (int e = 0; e < MEMO_ENTRIES; e++) {
+                #pragma HLS UNROLL
+                refilled[e] = false;
+            }
+
+            read_lanes: for (int lane = 0; lane < BAT_LANES; lane++) {
+                const int bat = group + lane;
+                int ones = 0;
+                // Entries refilled by an earlier lane still hold their old key
+                // until the chunks are forwarded, so they cannot hit
+                for (int e = 0; e < MEMO_ENTRIES; e++) {
+                    #pragma HLS UNROLL
+                    match[e] = memo_valid[e] && !refilled[e];
+                }
+                read_lane_chunks: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=rng_state inter distance=RNG_LANES true
+                    chunk_t genes = 0;
+                    if (bat < num_bats) {
+                        genes = generate ? random_chunk(rng_state, chunk, chromo_len) : chromosome_stream.read();
+                    }
+                    lane_chromo[lane][chunk] = genes;
+                    ones += count_genes(genes, chunk, chromo_len);
+                    if (bat < num_bats && bat < MAX_BATS) bat_chromo[bat][chunk] = genes;
+                    memo_compare: for (int e = 0; e < MEMO_ENTRIES; e++) {
+                        #pragma HLS UNROLL
+                        if (memo_key[e][chunk] != genes) match[e] = false;
+                    }
+                }
+                if (bat < num_bats && bat < MAX_BATS) bat_ones[bat] = ones;
+                const int verdict = memo_verdict(match, memo_valid, memo_count, memoize && bat < num_bats);
+                if (verdict >= 0 && !memo_hit(verdict)) refilled[verdict] = true;
+                lane_verdict[lane] = verdict;
+                memo_fifo.write(verdict);
+                ones_fifo.write(ones);
+            }
+
+            forward_lane_chunks: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                #pragma HLS PIPELINE II=1
+                lane_chunk_t beat;
+                for (int lane = 0; lane < BAT_LANES; lane++) {
+                    #pragma HLS UNROLL
+                    beat.range(lane * chunk_bits + chunk_bits - 1, lane * chunk_bits) = lane_chromo[lane][chunk];
+                    if (lane_verdict[lane] >= 0 && !memo_hit(lane_verdict[lane])) {
+                        memo_key[lane_verdict[lane]][chunk] = lane_chromo[lane][chunk];
+                    }
+                }
+                chunk_fifo.write(beat);
+            }
+        }
+    }
+
+    // Stage 2 (lanes): BAT_LANES bats per pass, every cache read is broadcast
+    // to one accumulator set per lane. Lanes are pruned individually; the
+    // group stops early only once every active lane is hopeless or a filter hit.
+    static void accumulate_lanes(
+        hls::stream<lane_chunk_t>& chunk_fifo,
+        hls::stream<int>& ones_fifo,
+        hls::stream<int>& memo_fifo,
+        hls::stream<sum_t>& sum_fifo,
+        hls::stream<int>& card_fifo,
+        hls::stream<bool>& pruned_fifo,
+        hls::stream<int>& verdict_fifo,
+        const store_t local_vector_cache[cache_size],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        float prune_limit
+    ) {
+        sum_t lane_sum[BAT_LANES][ACC_BANKS][max_dim];
+        bool lane_side[BAT_LANES];
+        int lane_ones[BAT_LANES];
+        int lane_verdict[BAT_LANES];
+        bool lane_pruned[BAT_LANES];
+        #pragma HLS ARRAY_PARTITION variable=lane_sum complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=lane_sum complete dim=2
+        #pragma HLS ARRAY_PARTITION variable=lane_sum cyclic factor=unroll dim=3
+        #pragma HLS ARRAY_PARTITION variable=lane_side complete
+        #pragma HLS ARRAY_PARTITION variable=lane_ones complete
+        #pragma HLS ARRAY_PARTITION variable=lane_verdict complete
+        #pragma HLS ARRAY_PARTITION variable=lane_pruned complete
+
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const int num_segments = (chromo_len + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL;
+
+        init_lane_sums: for (int i = 0; i < max_dim; i++) {
+            #pragma HLS PIPELINE II=1
+            for (int lane = 0; lane < BAT_LANES; lane++) {
+                #pragma HLS UNROLL
+                for (int b = 0; b < ACC_BANKS; b++) {
+                    #pragma HLS UNROLL
+                    lane_sum[lane][b][i] = 0;
+                }
+            }
+        }
+
+        accumulate_lane_groups: for (int group = 0; group < num_bats; group += BAT_LANES) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000/BAT_LANES
+
+            bool group_pruned = true;
+            pick_sides: for (int lane = 0; lane < BAT_LANES; lane++) {
+                const int verdict = memo_fifo.read();
+                const int ones = ones_fifo.read();
+                lane_side[lane] = ones <= chromo_len - ones;
+                lane_ones[lane] = ones;
+                lane_verdict[lane] = verdict;
+                // Inactive lanes and filter hits count as pruned so they never
+                // hold the group back
+                lane_pruned[lane] = group + lane >= num_bats || memo_hit(verdict);
+                group_pruned = group_pruned && lane_pruned[lane];
+            }
+
+            lane_chunk_t beat = 0;
+            int chunks_read = 0;
+
+            broadcast_segments: for (int seg = 0; seg < num_segments && !group_pruned; seg++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=prune_segments
+
+                int seg_end = (seg + 1) * PRUNE_INTERVAL;
+                if (seg_end > chromo_len) seg_end = chromo_len;
+
+                broadcast_genes: for (int gene_idx = seg * PRUNE_INTERVAL; gene_idx < seg_end; gene_idx++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=PRUNE_INTERVAL
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=lane_sum inter distance=ACC_BANKS true
+
+                    int bank = gene_idx % ACC_BANKS;
+                    int bit_idx = gene_idx % chunk_bits;
+
+                    if (bit_idx == 0) {
+                        beat = chunk_fifo.read();
+                        chunks_read++;
+                    }
+
+                    broadcast_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                        int d_end = d_block + unroll;
+                        if (d_end > dim) d_end = dim;
+
+                        for (int d = d_block; d < d_end; d++) {
+                            #pragma HLS UNROLL
+                            acc_t vector_val = store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+
+                            for (int lane = 0; lane < BAT_LANES; lane++) {
+                                #pragma HLS UNROLL
+                                bool gene_bit = beat[lane * chunk_bits + bit_idx];
+                                sum_t temp_sum = lane_sum[lane][bank][d];
+                                lane_sum[lane][bank][d] = temp_sum + (gene_bit == lane_side[lane] ? vector_val : acc_t(0));
+                            }
+                        }
+                    }
+                }
+
+                if (prune_limit > 0.0f && seg + 1 < num_segments) {
+                    group_pruned = true;
+                    check_lanes: for (int lane = 0; lane < BAT_LANES; lane++) {
+                        if (!lane_pruned[lane]) {
+                            lane_pruned[lane] = exceeds_bound(lane_sum[lane], lane_side[lane],
+                                                              prefix_total[seg + 1], suffix_abs[seg + 1],
+                                                              dim, prune_limit);
+                        }
+                        group_pruned = group_pruned && lane_pruned[lane];
+                    }
+                }
+            }
+
+            skip_lane_chunks: for (int c = chunks_read; c < num_chunks; c++) {
+                #pragma HLS PIPELINE II=1
+                chunk_fifo.read();
+            }
+
+            emit_lanes: for (int lane = 0; lane < BAT_LANES; lane++) {
+                const bool active = group + lane < num_bats;
+                if (active) {
+                    card_fifo.write(lane_ones[lane]);
+                    pruned_fifo.write(lane_pruned[lane] && !memo_hit(lane_verdict[lane]));
+                    verdict_fifo.write(lane_verdict[lane]);
+                }
+
+                emit_lane_sums: for (int d = 0; d < dim; d++) {
+                    #pragma HLS PIPELINE II=1
+                    sum_t merged = lane_sum[lane][0][d];
+                    merge_banks: for (int b = 1; b < ACC_BANKS; b++) {
+                        #pragma HLS UNROLL
+                        merged = merged + lane_sum[lane][b][d];
+                    }
+                    if (active) sum_fifo.write(merged);
+
+                    for (int b = 0; b < ACC_BANKS; b++) {
+                        #pragma HLS UNROLL
+                        lane_sum[lane][b][d] = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    // Stage 3: sumA - sumB from the accumulated side and the total vector,
+    // then the distance reduction. Pruned bats report PRUNED_FITNESS; their
+    // difference is partial, so it is not kept and bat_valid marks the
+    // resident chromosome as lacking one for MODE_INCREMENTAL. With
+    // top_k > 0 only the K best unpruned bats are written, after the last bat.
+    // With pack_results the fitness values leave as records on record_stream.
+    // best_resident returns the best unpruned bat with a resident chromosome.
+    // A filter hit takes its difference from memo_diff; a miss stores it there.
+    static void reduce_bats(
+        hls::stream<sum_t>& sum_fifo,
+        hls::stream<int>& card_fifo,
+        hls::stream<bool>& pruned_fifo,
+        hls::stream<int>& verdict_fifo,
+        acc_t memo_diff[MEMO_ENTRIES][max_dim],
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const sum_t total_vector[max_dim],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        int top_k,
+        bool pack_results,
+        int& best_resident
+    ) {
+        acc_t diff_vec[max_dim];
+        #pragma HLS ARRAY_PARTITION variable=diff_vec cyclic factor=unroll
+
+        float resident_fitness = 0.0f;
+        int resident_bat = -1;
+
+        float best_fitness[TOPK_MAX];
+        int best_bat[TOPK_MAX];
+        int best_ones[TOPK_MAX];
+        #pragma HLS ARRAY_PARTITION variable=best_fitness complete
+        #pragma HLS ARRAY_PARTITION variable=best_bat complete
+        #pragma HLS ARRAY_PARTITION variable=best_ones complete
+        topk_reset(best_fitness, best_bat, best_ones);
+
+        result_beat_t beat = 0;
+        int fill = 0;
+
+        reduce_batches: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
+
+            const int ones = card_fifo.read();
+            const bool side = ones <= chromo_len - ones;
+            const bool pruned = pruned_fifo.read();
+            const int verdict = verdict_fifo.read();
+
+            derive_diff: for (int d = 0; d < dim; d++) {
+                #pragma HLS PIPELINE II=1
+                sum_t merged = sum_fifo.read();
+                sum_t twice_sum = merged + merged;
+                diff_vec[d] = sum_value(side ? total_vector[d] - twice_sum : twice_sum - total_vector[d]);
+                if (memo_hit(verdict)) diff_vec[d] = memo_diff[verdict - MEMO_ENTRIES][d];
+                else if (verdict >= 0) memo_diff[verdict][d] = diff_vec[d];
+                // Keep the difference resident for later MODE_INCREMENTAL calls
+                if (bat < MAX_BATS && !pruned) bat_diff[bat][d] = diff_vec[d];
+            }
+            if (bat < MAX_BATS) bat_valid[bat] = !pruned;
+
+            float fitness = compute_objective(diff_vec, dim, objective);
+            if (bat < MAX_BATS && !pruned && (resident_bat < 0 || fitness < resident_fitness)) {
+                resident_fitness = fitness;
+                resident_bat = bat;
+            }
+            if (top_k > 0) {
+                if (!pruned) topk_insert(best_fitness, best_bat, best_ones, fitness, bat, ones, top_k);
+            } else {
+                if (pack_results) {
+                    record_put(record_stream, beat, fill, pruned ? PRUNED_FITNESS : fitness, bat, ones);
+                } else {
+                    result_stream.write(pruned ? PRUNED_FITNESS : fitness);
+                }
+                if (emit_diff) emit_difference(result_stream, diff_vec, dim);
+            }
+        }
+
+        if (top_k > 0) {
+            topk_emit(result_stream, record_stream, beat, fill, pack_results, best_fitness, best_bat, best_ones,
+                      top_k);
+        }
+        if (pack_results) record_flush(record_stream, beat, fill);
+        best_resident = resident_bat;
+    }
+
+    static void evaluate_population(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        hls::stream<result_beat_t>& record_stream,
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        acc_t memo_diff[MEMO_ENTRIES][max_dim],
+        unsigned int memo_count[2],
+        bool generate,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        float prune_limit,
+        int top_k,
+        bool pack_results,
+        int& best_resident
+    ) {
+        #pragma HLS DATAFLOW
+
+        // The filter only holds complete differences, so it is off while pruning
+        const bool memoize = prune_limit <= 0.0f;
+
+        hls::stream<int> ones_fifo("ones_fifo");
+        hls::stream<sum_t> sum_fifo("sum_fifo");
+        hls::stream<int> card_fifo("card_fifo");
+        hls::stream<bool> pruned_fifo("pruned_fifo");
+        hls::stream<int> memo_fifo("memo_fifo");
+        hls::stream<int> verdict_fifo("verdict_fifo");
+        #pragma HLS STREAM variable=ones_fifo depth=2*(BAT_LANES+prune_segments)
+        #pragma HLS STREAM variable=sum_fifo depth=max_dim
+        #pragma HLS STREAM variable=card_fifo depth=2
+        #pragma HLS STREAM variable=pruned_fifo depth=2
+        #pragma HLS STREAM variable=memo_fifo depth=2*BAT_LANES
+        #pragma HLS STREAM variable=verdict_fifo depth=2
+
+#if BAT_LANES > 1
+        hls::stream<lane_chunk_t> chunk_fifo("chunk_fifo");
+        #pragma HLS STREAM variable=chunk_fifo depth=max_chunks
+
+        read_lanes(chromosome_stream, chunk_fifo, ones_fifo, memo_fifo, bat_chromo, bat_ones, rng_state,
+                   memo_key, memo_valid, memo_count, memoize, generate, chromo_len, num_bats);
+        accumulate_lanes(chunk_fifo, ones_fifo, memo_fifo, sum_fifo, card_fifo, pruned_fifo, verdict_fifo,
+                         local_vector_cache, prefix_total, suffix_abs, chromo_len, dim, num_bats, prune_limit);
+#else
+        hls::stream<chunk_t> chunk_fifo("chunk_fifo");
+        #pragma HLS STREAM variable=chunk_fifo depth=max_chunks
+
+        read_sparse(chromosome_stream, chunk_fifo, ones_fifo, memo_fifo, bat_chromo, bat_ones, rng_state,
+                    memo_key, memo_valid, memo_count, memoize, generate, chromo_len, num_bats);
+        accumulate_sparse(chunk_fifo, ones_fifo, memo_fifo, sum_fifo, card_fifo, pruned_fifo, verdict_fifo,
+                          local_vector_cache, prefix_total, suffix_abs, chromo_len, dim, num_bats, prune_limit);
+#endif
+        reduce_bats(sum_fifo, card_fifo, pruned_fifo, verdict_fifo, memo_diff, result_stream, record_stream,
+                    total_vector, bat_diff, bat_valid, chromo_len, dim, num_bats, objective, emit_diff, top_k,
+                    pack_results, best_resident);
+    }
+
+    // Compute path for a dim-major cache: the chunk-parallel stage replaces
+    // the gene walk and the bat lanes
+    static void evaluate_transposed(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        hls::stream<result_beat_t>& record_stream,
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        acc_t memo_diff[MEMO_ENTRIES][max_dim],
+        unsigned int memo_count[2],
+        bool generate,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        float prune_limit,
+        int top_k,
+        bool pack_results,
+        int& best_resident
+    ) {
+        #pragma HLS DATAFLOW
+
+        // The filter only holds complete differences, so it is off while pruning
+        const bool memoize = prune_limit <= 0.0f;
+
+        hls::stream<chunk_t> chunk_fifo("chunk_fifo");
+        hls::stream<int> ones_fifo("ones_fifo");
+        hls::stream<sum_t> sum_fifo("sum_fifo");
+        hls::stream<int> card_fifo("card_fifo");
+        hls::stream<bool> pruned_fifo("pruned_fifo");
+        hls::stream<int> memo_fifo("memo_fifo");
+        hls::stream<int> verdict_fifo("verdict_fifo");
+        #pragma HLS STREAM variable=chunk_fifo depth=max_chunks
+        #pragma HLS STREAM variable=ones_fifo depth=2*(1+prune_segments)
+        #pragma HLS STREAM variable=sum_fifo depth=max_dim
+        #pragma HLS STREAM variable=card_fifo depth=2
+        #pragma HLS STREAM variable=pruned_fifo depth=2
+        #pragma HLS STREAM variable=memo_fifo depth=2
+        #pragma HLS STREAM variable=verdict_fifo depth=2
+
+        read_sparse(chromosome_stream, chunk_fifo, ones_fifo, memo_fifo, bat_chromo, bat_ones, rng_state,
+                    memo_key, memo_valid, memo_count, memoize, generate, chromo_len, num_bats);
+        accumulate_transposed(chunk_fifo, ones_fifo, memo_fifo, sum_fifo, card_fifo, pruned_fifo, verdict_fifo,
+                              local_vector_cache, prefix_total, suffix_abs, chromo_len, dim, num_bats,
+                              prune_limit);
+        reduce_bats(sum_fifo, card_fifo, pruned_fifo, verdict_fifo, memo_diff, result_stream, record_stream,
+                    total_vector, bat_diff, bat_valid, chromo_len, dim, num_bats, objective, emit_diff, top_k,
+                    pack_results, best_resident);
+    }
+
+    // --- OUT-OF-CORE PATH ---
+    // Instances beyond max_genes * max_dim stay in DDR. They are streamed in
+    // OOC_TILE_GENES-gene tiles through two buffers: tile t+1 is fetched while
+    // tile t is applied to the whole resident population.
+
+    // Copy one tile of gene vectors from DDR; tiles past chromo_len are empty
+    static void load_tile(
+        const float* vectors_in,
+        acc_t tile[OOC_TILE_GENES * max_dim],
+        int first_gene,
+        int chromo_len,
+        int dim
+    ) {
+        #pragma HLS INLINE off
+        int tile_genes = chromo_len - first_gene;
+        if (tile_genes > OOC_TILE_GENES) tile_genes = OOC_TILE_GENES;
+        if (tile_genes < 0) tile_genes = 0;
+        const int tile_elements = tile_genes * dim;
+        const int tile_base = first_gene * dim;
+
+        load_tile_elements: for (int i = 0; i < tile_elements; i++) {
+            #pragma HLS PIPELINE II=1
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=OOC_TILE_GENES*max_dim
+            tile[i] = acc_t(vectors_in[tile_base + i]);
+        }
+    }
+
+    // Apply one tile to every bat's signed difference (bit 0 adds, bit 1
+    // subtracts). Bats are the inner loop, so each tile element is reused
+    // across the population and an accumulator is revisited only every
+    // num_bats iterations; short populations are padded to ACC_BANKS.
+    static void accumulate_tile(
+        const acc_t tile[OOC_TILE_GENES * max_dim],
+        const chunk_t pop_chromo[MAX_BATS][ooc_max_chunks],
+        acc_t pop_diff[MAX_BATS][max_dim],
+        int first_gene,
+        int chromo_len,
+        int dim,
+        int num_bats
+    ) {
+        #pragma HLS INLINE off
+        int tile_genes = chromo_len - first_gene;
+        if (tile_genes > OOC_TILE_GENES) tile_genes = OOC_TILE_GENES;
+        const int bat_span = num_bats < ACC_BANKS ? ACC_BANKS : num_bats;
+
+        tile_genes_loop: for (int g = 0; g < tile_genes; g++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=OOC_TILE_GENES
+            tile_bats: for (int bat = 0; bat < bat_span; bat++) {
+                #pragma HLS LOOP_TRIPCOUNT min=ACC_BANKS max=MAX_BATS
+                #pragma HLS PIPELINE II=1
+                #pragma HLS DEPENDENCE variable=pop_diff inter distance=ACC_BANKS true
+
+                if (bat < num_bats) {
+                    const int gene_idx = first_gene + g;
+                    bool gene_bit = pop_chromo[bat][gene_idx / chunk_bits][gene_idx % chunk_bits];
+                    const int vector_base = g * dim;
+
+                    tile_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                        int d_end = d_block + unroll;
+                        if (d_end > dim) d_end = dim;
+
+                        for (int d = d_block; d < d_end; d++) {
+                            #pragma HLS UNROLL
+                            acc_t vector_val = tile[vector_base + d];
+                            acc_t temp_diff = pop_diff[bat][d];
+                            pop_diff[bat][d] = gene_bit ? acc_t(temp_diff - vector_val) : acc_t(temp_diff + vector_val);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    static void evaluate_out_of_core(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        int top_k,
+        bool pack_results
+    ) {
+        chunk_t pop_chromo[MAX_BATS][ooc_max_chunks];
+        int pop_ones[MAX_BATS];
+        acc_t pop_diff[MAX_BATS][max_dim];
+        acc_t no_diff[max_dim];
+        acc_t tile_ping[OOC_TILE_GENES * max_dim];
+        acc_t tile_pong[OOC_TILE_GENES * max_dim];
+        #pragma HLS ARRAY_PARTITION variable=pop_diff cyclic factor=unroll dim=2
+        #pragma HLS ARRAY_PARTITION variable=tile_ping cyclic factor=unroll
+        #pragma HLS ARRAY_PARTITION variable=tile_pong cyclic factor=unroll
+
+        // Only the first MAX_BATS bats of an instance within OOC_MAX_GENES x
+        // max_dim are evaluated; the rest are still read, to keep the stream
+        // in step, and report PRUNED_FITNESS
+        const bool fits = chromo_len <= OOC_MAX_GENES && dim <= max_dim;
+        const int bats = !fits ? 0 : num_bats > MAX_BATS ? MAX_BATS : num_bats;
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const int num_tiles = bats > 0 ? (chromo_len + OOC_TILE_GENES - 1) / OOC_TILE_GENES : 0;
+
+        clear_no_diff: for (int d = 0; d < max_dim; d++) {
+            #pragma HLS PIPELINE II=1
+            no_diff[d] = 0;
+        }
+
+        // The whole population is read up front and stays resident
+        read_population: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATS
+            read_population_chunks: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                #pragma HLS PIPELINE II=1
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=ooc_max_chunks
+                chunk_t genes = chromosome_stream.read();
+                if (bat < bats) {
+                    pop_chromo[bat][chunk] = genes;
+                    pop_ones[bat] = (chunk == 0 ? 0 : pop_ones[bat]) + count_genes(genes, chunk, chromo_len);
+                }
+            }
+            if (bat < bats) {
+                clear_population_diff: for (int d = 0; d < max_dim; d++) {
+                    #pragma HLS PIPELINE II=1
+                    pop_diff[bat][d] = 0;
+                }
+            }
+        }
+
+        if (num_tiles > 0) load_tile(vectors_in, tile_ping, 0, chromo_len, dim);
+
+        // Ping-pong: the two calls in each branch touch different buffers, so
+        // the prefetch of tile t+1 runs alongside the accumulation of tile t
+        stream_tiles: for (int t = 0; t < num_tiles; t++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=OOC_MAX_GENES/OOC_TILE_GENES
+            const int first_gene = t * OOC_TILE_GENES;
+            const int next_gene = first_gene + OOC_TILE_GENES;
+
+            if (t % 2 == 0) {
+                load_tile(vectors_in, tile_pong, next_gene, chromo_len, dim);
+                accumulate_tile(tile_ping, pop_chromo, pop_diff, first_gene, chromo_len, dim, bats);
+            } else {
+                load_tile(vectors_in, tile_ping, next_gene, chromo_len, dim);
+                accumulate_tile(tile_pong, pop_chromo, pop_diff, first_gene, chromo_len, dim, bats);
+            }
+        }
+
+        float best_fitness[TOPK_MAX];
+        int best_bat[TOPK_MAX];
+        int best_ones[TOPK_MAX];
+        #pragma HLS ARRAY_PARTITION variable=best_fitness complete
+        #pragma HLS ARRAY_PARTITION variable=best_bat complete
+        #pragma HLS ARRAY_PARTITION variable=best_ones complete
+        topk_reset(best_fitness, best_bat, best_ones);
+
+        result_beat_t beat = 0;
+        int fill = 0;
+
+        reduce_population: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATS
+            const bool evaluated = bat < bats;
+            const float fitness = evaluated ? compute_objective(pop_diff[bat], dim, objective) : PRUNED_FITNESS;
+            const int ones = evaluated ? pop_ones[bat] : 0;
+            if (top_k > 0) {
+                if (evaluated) topk_insert(best_fitness, best_bat, best_ones, fitness, bat, ones, top_k);
+            } else {
+                if (pack_results) {
+                    record_put(record_stream, beat, fill, fitness, bat, ones);
+                } else {
+                    result_stream.write(fitness);
+                }
+                if (emit_diff) emit_difference(result_stream, evaluated ? pop_diff[bat] : no_diff, dim);
+            }
+        }
+
+        if (top_k > 0) {
+            topk_emit(result_stream, record_stream, beat, fill, pack_results, best_fitness, best_bat, best_ones,
+                      top_k);
+        }
+        if (pack_results) record_flush(record_stream, beat, fill);
+    }
+
+    // --- BAT ALGORITHM ENGINE ---
+    // Binary bat algorithm with a V-shaped transfer function. Positions and
+    // their differences live in bat_chromo / bat_diff, so MODE_INCREMENTAL can
+    // continue from the final population. A candidate is built gene by gene
+    // against a base position (the bat's own, or the global best for a local
+    // step) and only the genes it flips touch the cache.
+
+    // base_diff + the banked flip contributions, banks cleared for the next candidate
+    template <typename B>
+    static void merge_flips(
+        const B base_diff[max_dim],
+        acc_t flip_sum[ACC_BANKS][max_dim],
+        acc_t out_diff[max_dim],
+        int dim
+    ) {
+        #pragma HLS INLINE
+        merge_flip_dims: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            acc_t merged = sum_value(base_diff[d]);
+            for (int b = 0; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                merged = merged + flip_sum[b][d];
+                flip_sum[b][d] = 0;
+            }
+            out_diff[d] = merged;
+        }
+    }
+
+    static void run_bat_engine(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        chunk_t* best_chromo_out,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        velocity_t bat_velocity[ENGINE_MAX_BATS][max_genes],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        unsigned int rng_state[RNG_LANES][4],
+        int num_generations
+    ) {
+        const int vel_limit = BAT_VMAX << BAT_VEL_FRAC_BITS;
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const int bats = num_bats > ENGINE_MAX_BATS ? ENGINE_MAX_BATS : num_bats;
+
+        float fitness[ENGINE_MAX_BATS];
+        float loudness[ENGINE_MAX_BATS];
+        float pulse_rate[ENGINE_MAX_BATS];
+        chunk_t best_chromo[max_chunks];
+        chunk_t cand_chromo[max_chunks];
+        acc_t best_diff[max_dim];
+        acc_t cand_diff[max_dim];
+        acc_t flip_sum[ACC_BANKS][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=best_diff cyclic factor=unroll
+        #pragma HLS ARRAY_PARTITION variable=cand_diff cyclic factor=unroll
+        #pragma HLS ARRAY_PARTITION variable=flip_sum complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=flip_sum cyclic factor=unroll dim=2
+
+        // Without bats there is no best: PRUNED_FITNESS and a zero chromosome
+        float best_fitness = PRUNED_FITNESS;
+        if (bats == 0) {
+            clear_best_chromo: for (int c = 0; c < num_chunks; c++) {
+                #pragma HLS PIPELINE II=1
+                best_chromo[c] = 0;
+            }
+            clear_best_diff: for (int d = 0; d < dim; d++) {
+                #pragma HLS PIPELINE II=1
+                best_diff[d] = 0;
+            }
+        }
+
+        // Flip probability |2/pi * atan(pi/2 * v)| per velocity step, as a
+        // 16-bit threshold against the RNG. Built by the first MODE_BAT call
+        // and kept, so later calls skip the atan evaluations.
+        static ap_uint<16> transfer_lut[(BAT_VMAX << BAT_VEL_FRAC_BITS) + 1];
+        static bool transfer_built = false;
+        if (!transfer_built) {
+            build_transfer: for (int i = 0; i <= vel_limit; i++) {
+                #pragma HLS PIPELINE II=1
+                float v = static_cast<float>(i) / (1 << BAT_VEL_FRAC_BITS);
+                float p = hls::fabs(0.63661977f * hls::atan(1.57079633f * v));
+                transfer_lut[i] = p >= 1.0f ? 65535 : static_cast<int>(p * 65536.0f);
+            }
+            transfer_built = true;
+        }
+
+        init_flip_sums: for (int d = 0; d < max_dim; d++) {
+            #pragma HLS PIPELINE II=1
+            for (int b = 0; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                flip_sum[b][d] = 0;
+            }
+        }
+
+        // Initial population from the stream: sumA - sumB = T - 2*sumB,
+        // i.e. every set gene is a flip away from the all-A partition
+        init_population: for (int bat = 0; bat < bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=ENGINE_MAX_BATS
+            chunk_t genes = 0;
+            int ones = 0;
+
+            init_genes: for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=max_genes
+                #pragma HLS PIPELINE II=1
+                #pragma HLS DEPENDENCE variable=flip_sum inter distance=ACC_BANKS true
+                const int chunk = gene_idx / chunk_bits;
+                const int bit_idx = gene_idx % chunk_bits;
+                const int bank = gene_idx % ACC_BANKS;
+
+                if (bit_idx == 0) {
+                    genes = chromosome_stream.read();
+                    bat_chromo[bat][chunk] = genes;
+                    ones += count_genes(genes, chunk, chromo_len);
+                }
+                bat_velocity[bat][gene_idx] = 0;
+
+                init_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                    int d_end = d_block + unroll;
+                    if (d_end > dim) d_end = dim;
+
+                    for (int d = d_block; d < d_end; d++) {
+                        #pragma HLS UNROLL
+                        acc_t vector_val = store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                        acc_t temp_sum = flip_sum[bank][d];
+                        flip_sum[bank][d] = temp_sum - (genes[bit_idx] ? acc_t(vector_val + vector_val) : acc_t(0));
+                    }
+                }
+            }
+
+            bat_ones[bat] = ones;
+            merge_flips(total_vector, flip_sum, bat_diff[bat], dim);
+            bat_valid[bat] = true;
+            fitness[bat] = compute_objective(bat_diff[bat], dim, objective);
+            loudness[bat] = BAT_LOUDNESS0;
+            pulse_rate[bat] = 0.0f;
+
+            if (bat == 0 || fitness[bat] <= best_fitness) {
+                best_fitness = fitness[bat];
+                copy_init_best: for (int c = 0; c < num_chunks; c++) {
+                    #pragma HLS PIPELINE II=1
+                    best_chromo[c] = bat_chromo[bat][c];
+                }
+                copy_init_diff: for (int d = 0; d < dim; d++) {
+                    #pragma HLS PIPELINE II=1
+                    best_diff[d] = bat_diff[bat][d];
+                }
+            }
+        }
+
+        // Bats past ENGINE_MAX_BATS stay out of the population, but their
+        // chromosomes are consumed so the next call starts on its own input
+        drain_surplus: for (int w = 0; w < (num_bats - bats) * num_chunks; w++) {
+            #pragma HLS LOOP_TRIPCOUNT min=0 max=max_chunks
+            #pragma HLS PIPELINE II=1
+            chromosome_stream.read();
+        }
+
+        generations: for (int t = 1; t <= num_generations; t++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=1000
+            // Pulse rate an accepting bat moves to: r0 * (1 - exp(-gamma * t))
+            const float pulse_target = BAT_PULSE0 * (1.0f - hls::exp(-BAT_GAMMA * t));
+
+            fly_bats: for (int bat = 0; bat < bats; bat++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=ENGINE_MAX_BATS
+                // Frequency in velocity steps; a local step perturbs the best.
+                // Per-bat draws come from lane 0, per-gene draws round-robin.
+                const float beta = uniform(rng_state[0]);
+                const int freq = static_cast<int>((BAT_FMIN + (BAT_FMAX - BAT_FMIN) * beta) * (1 << BAT_VEL_FRAC_BITS));
+                const bool local = uniform(rng_state[0]) > pulse_rate[bat];
+                chunk_t own_genes = 0;
+                chunk_t best_genes = 0;
+                chunk_t cand_genes = 0;
+                int cand_ones = 0;
+
+                fly_genes: for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=max_genes
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=flip_sum inter distance=ACC_BANKS true
+                    #pragma HLS DEPENDENCE variable=rng_state inter distance=RNG_LANES true
+                    const int chunk = gene_idx / chunk_bits;
+                    const int bit_idx = gene_idx % chunk_bits;
+                    const int bank = gene_idx % ACC_BANKS;
+
+                    if (bit_idx == 0) {
+                        own_genes = bat_chromo[bat][chunk];
+                        best_genes = best_chromo[chunk];
+                        cand_genes = 0;
+                    }
+                    const bool own_bit = own_genes[bit_idx];
+                    const bool best_bit = best_genes[bit_idx];
+                    const bool base_bit = local ? best_bit : own_bit;
+
+                    // v += (x - x_best) * f, clamped to +-BAT_VMAX
+                    int velocity = bat_velocity[bat][gene_idx];
+                    if (own_bit && !best_bit) velocity += freq;
+                    if (!own_bit && best_bit) velocity -= freq;
+                    if (velocity > vel_limit) velocity = vel_limit;
+                    if (velocity < -vel_limit) velocity = -vel_limit;
+                    bat_velocity[bat][gene_idx] = velocity;
+
+                    const int speed = velocity < 0 ? -velocity : velocity;
+                    const bool flip = (rng_next(rng_state[gene_idx % RNG_LANES]) & 0xFFFF) < transfer_lut[speed];
+                    cand_genes[bit_idx] = base_bit ^ flip;
+                    cand_ones += (base_bit ^ flip) ? 1 : 0;
+                    if (bit_idx == chunk_bits - 1 || gene_idx == chromo_len - 1) cand_chromo[chunk] = cand_genes;
+
+                    // A -> B lowers sumA - sumB by 2v, B -> A raises it
+                    fly_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                        int d_end = d_block + unroll;
+                        if (d_end > dim) d_end = dim;
+
+                        for (int d = d_block; d < d_end; d++) {
+                            #pragma HLS UNROLL
+                            acc_t vector_val = store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                            acc_t twice_val = vector_val + vector_val;
+                            acc_t temp_sum = flip_sum[bank][d];
+                            flip_sum[bank][d] = temp_sum + (!flip ? acc_t(0) : base_bit ? twice_val : acc_t(-twice_val));
+                        }
+                    }
+                }
+
+                merge_flips(local ? best_diff : bat_diff[bat], flip_sum, cand_diff, dim);
+                const float cand_fitness = compute_objective(cand_diff, dim, objective);
+
+                // Accept with probability A_i if not worse; loudness decays
+                // and the pulse rate grows with every accepted move
+                if (uniform(rng_state[0]) < loudness[bat] && cand_fitness <= fitness[bat]) {
+                    fitness[bat] = cand_fitness;
+                    loudness[bat] = BAT_ALPHA * loudness[bat];
+                    pulse_rate[bat] = pulse_target;
+                    bat_ones[bat] = cand_ones;
+                    accept_chromo: for (int c = 0; c < num_chunks; c++) {
+                        #pragma HLS PIPELINE II=1
+                        bat_chromo[bat][c] = cand_chromo[c];
+                    }
+                    accept_diff: for (int d = 0; d < dim; d++) {
+                        #pragma HLS PIPELINE II=1
+                        bat_diff[bat][d] = cand_diff[d];
+                    }
+                }
+
+                if (cand_fitness <= best_fitness) {
+                    best_fitness = cand_fitness;
+                    update_best_chromo: for (int c = 0; c < num_chunks; c++) {
+                        #pragma HLS PIPELINE II=1
+                        best_chromo[c] = cand_chromo[c];
+                    }
+                    update_best_diff: for (int d = 0; d < dim; d++) {
+                        #pragma HLS PIPELINE II=1
+                        best_diff[d] = cand_diff[d];
+                    }
+                }
+            }
+        }
+
+        write_best: for (int c = 0; c < num_chunks; c++) {
+            #pragma HLS PIPELINE II=1
+            best_chromo_out[c] = best_chromo[c];
+        }
+        result_stream.write(best_fitness);
+        if (emit_diff) emit_difference(result_stream, best_diff, dim);
+    }
+
+    // Copy resident chromosome `bat` to best_chromo_out (nothing if bat < 0)
+    static void write_resident(
+        chunk_t* best_chromo_out,
+        const chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat,
+        int chromo_len
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        if (bat < 0) return;
+
+        write_resident_chunks: for (int c = 0; c < num_chunks; c++) {
+            #pragma HLS PIPELINE II=1
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=max_chunks
+            best_chromo_out[c] = bat_chromo[bat][c];
+        }
+    }
+
+    // --- INSTANCE LOADING ---
+
+    // Copy a chromo_len x dim instance into one cache bank and rebuild its
+    // total vector and pruning bounds. wide selects the 512-bit vectors_wide
+    // port, whose buffer is padded to a whole number of beats.
+    static void load_bank(
+        const float* vectors_in,
+        const wide_t* vectors_wide,
+        bool wide,
+        store_t local_vector_cache[cache_size],
+        sum_t total_vector[max_dim],
+        acc_t prefix_total[prune_segments + 1][max_dim],
+        acc_t suffix_abs[prune_segments + 1][max_dim],
+        int chromo_len,
+        int dim
+    ) {
+        // A zero-length preload leaves the shadow bank as it was
+        if (chromo_len <= 0) return;
+
+        int total_elements = chromo_len * dim;
+
+        if (wide) {
+            // One 512-bit beat per cycle, unpacked into wire_values banks
+            // (WIDE_FLOATS floats, or WIDE_HALVES values of a 16-bit store_t).
+            // The host buffer is padded to a whole number of beats.
+            int total_beats = (total_elements + wire_values - 1) / wire_values;
+            int beat_gene = 0;
+            int beat_d = 0;
+
+            load_cache_wide: for (int beat = 0; beat < total_beats; beat++) {
+                #pragma HLS PIPELINE II=1
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=(max_genes*max_dim+wire_values-1)/wire_values
+                wide_t word = vectors_wide[beat];
+                int gene_idx = beat_gene;
+                int d = beat_d;
+
+                for (int k = 0; k < wire_values; k++) {
+                    #pragma HLS UNROLL
+                    int i = beat * wire_values + k;
+                    if (i < total_elements) {
+                        local_vector_cache[dim_major ? cache_index(gene_idx, d, dim) : i] =
+                            store::from_wire(word.range(wire_bits * k + wire_bits - 1, wire_bits * k));
+                    }
+                    next_element(gene_idx, d, dim);
+                }
+                beat_gene = gene_idx;
+                beat_d = d;
+            }
+        } else {
+            int gene_idx = 0;
+            int d = 0;
+
+            load_cache: for (int i = 0; i < total_elements; i++) {
+                #pragma HLS PIPELINE II=1
+                // Converted once here (to acc_t, or rounded to a 16-bit store_t)
+                local_vector_cache[dim_major ? cache_index(gene_idx, d, dim) : i] = store::narrow(vectors_in[i]);
+                next_element(gene_idx, d, dim);
+            }
+        }
+
+        acc_t total_abs[max_dim];
+        #pragma HLS ARRAY_PARTITION variable=total_abs cyclic factor=unroll
+
+        init_total: for (int d = 0; d < max_dim; d++) {
+            #pragma HLS PIPELINE II=1
+            total_vector[d] = 0;
+            total_abs[d] = 0;
+            prefix_total[0][d] = 0;
+            suffix_abs[0][d] = 0;
+        }
+
+        compute_total: for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
+            #pragma HLS PIPELINE II=1
+
+            total_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                int d_end = d_block + unroll;
+                if (d_end > dim) d_end = dim;
+
+                for (int d = d_block; d < d_end; d++) {
+                    #pragma HLS UNROLL
+                    acc_t vector_val = store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                    total_vector[d] = total_vector[d] + vector_val;
+                    total_abs[d] = total_abs[d] + (vector_val < acc_t(0) ? acc_t(-vector_val) : vector_val);
+
+                    // Checkpoint after the last gene of each pruning segment;
+                    // suffix_abs holds the prefix mass until finish_bounds
+                    if ((gene_idx + 1) % PRUNE_INTERVAL == 0) {
+                        prefix_total[(gene_idx + 1) / PRUNE_INTERVAL][d] = sum_value(total_vector[d]);
+                        suffix_abs[(gene_idx + 1) / PRUNE_INTERVAL][d] = total_abs[d];
+                    }
+                }
+            }
+        }
+
+        finish_bounds: for (int seg = 0; seg < (chromo_len + PRUNE_INTERVAL - 1) / PRUNE_INTERVAL; seg++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=prune_segments
+            for (int d = 0; d < dim; d++) {
+                #pragma HLS PIPELINE II=1
+                suffix_abs[seg][d] = total_abs[d] - suffix_abs[seg][d];
+            }
+        }
+    }
+
+    // sumA - sumB of a resident chromosome: its minority side accumulated into
+    // ACC_BANKS round-robin partial sums, gene by gene as in accumulate_sparse
+    static void derive_difference(
+        const chunk_t chromo[max_chunks],
+        int ones,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        acc_t diff_vec[max_dim],
+        int chromo_len,
+        int dim
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const bool side = ones <= chromo_len - ones;
+        const int side_genes = side ? ones : chromo_len - ones;
+
+        sum_t side_sum[ACC_BANKS][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=side_sum complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=side_sum cyclic factor=unroll dim=2
+
+        derive_clear: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            for (int b = 0; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                side_sum[b][d] = 0;
+            }
+        }
+
+        int chunk_idx = -1;
+        int bank = 0;
+        chunk_t pending = 0;
+        derive_genes: for (int step = 0; step < num_chunks + side_genes; step++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=max_chunks+max_genes/2
+            #pragma HLS PIPELINE II=1
+            #pragma HLS DEPENDENCE variable=side_sum inter distance=ACC_BANKS true
+
+            if (pending == 0) {
+                chunk_idx++;
+                pending = select_side(chromo[chunk_idx], side, chunk_idx, chromo_len);
+            } else {
+                int bit_idx = lowest_set_bit(pending);
+                pending &= pending - 1;
+                int gene_idx = chunk_idx * chunk_bits + bit_idx;
+
+                derive_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                    int d_end = d_block + unroll;
+                    if (d_end > dim) d_end = dim;
+
+                    for (int d = d_block; d < d_end; d++) {
+                        #pragma HLS UNROLL
+                        sum_t temp_sum = side_sum[bank][d];
+                        side_sum[bank][d] = temp_sum + store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                    }
+                }
+
+                bank = (bank == ACC_BANKS - 1) ? 0 : bank + 1;
+            }
+        }
+
+        derive_merge: for (int d = 0; d < dim; d++) {
+            #pragma HLS PIPELINE II=1
+            sum_t merged = side_sum[0][d];
+            for (int b = 1; b < ACC_BANKS; b++) {
+                #pragma HLS UNROLL
+                merged = merged + side_sum[b][d];
+            }
+            sum_t twice_sum = merged + merged;
+            diff_vec[d] = sum_value(side ? total_vector[d] - twice_sum : twice_sum - total_vector[d]);
+        }
+    }
+
+    // sumA - sumB after flipping gene_idx away from old_bit: A -> B lowers it
+    // by 2v, B -> A raises it. `to` may be `from`.
+    static void flip_difference(
+        const acc_t from[max_dim],
+        acc_t to[max_dim],
+        const store_t local_vector_cache[cache_size],
+        int gene_idx,
+        bool old_bit,
+        int dim
+    ) {
+        #pragma HLS INLINE
+        flip_dims: for (int d_block = 0; d_block < dim; d_block += unroll) {
+            int d_end = d_block + unroll;
+            if (d_end > dim) d_end = dim;
+
+            for (int d = d_block; d < d_end; d++) {
+                #pragma HLS UNROLL
+                acc_t vector_val = store::widen(local_vector_cache[cache_index(gene_idx, d, dim)]);
+                acc_t twice_val = vector_val + vector_val;
+                to[d] = old_bit ? acc_t(from[d] + twice_val) : acc_t(from[d] - twice_val);
+            }
+        }
+    }
+
+    // --- MODE 9: ONE-FLIP NEIGHBORHOOD SCAN ---
+    // Per bat: read one chromosome and form its sumA - sumB from the minority
+    // side with derive_difference, then score all chromo_len single-gene flips
+    // from D -/+ 2v_gene, O(dim) each instead of a full evaluation. Flips are
+    // scored one dim block at a time across all genes, so the gene loop
+    // carries nothing and pipelines at II=1. The chromosome and D stay
+    // resident, so MODE_INCREMENTAL can take the move.
+    static void scan_neighbors(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int objective,
+        bool emit_diff,
+        int top_slots,
+        bool pack_results
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+
+        chunk_t chromo_buffer[max_chunks];
+        acc_t diff_vec[max_dim];
+        #pragma HLS ARRAY_PARTITION variable=diff_vec cyclic factor=unroll
+
+        // Per-flip objective partials over the dim blocks done so far
+        float flip_squares[max_genes];
+        float flip_abs[max_genes];
+        float flip_max[max_genes];
+
+        float best_fitness[TOPK_MAX];
+        int best_gene[TOPK_MAX];
+        int best_ones[TOPK_MAX];
+        #pragma HLS ARRAY_PARTITION variable=best_fitness complete
+        #pragma HLS ARRAY_PARTITION variable=best_gene complete
+        #pragma HLS ARRAY_PARTITION variable=best_ones complete
+
+        result_beat_t beat = 0;
+        int fill = 0;
+
+        scan_batches: for (int bat = 0; bat < num_bats; bat++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATS
+
+            int ones = 0;
+            scan_read: for (int chunk = 0; chunk < num_chunks; chunk++) {
+                #pragma HLS PIPELINE II=1
+                chunk_t genes = chromosome_stream.read();
+                chromo_buffer[chunk] = genes;
+                ones += count_genes(genes, chunk, chromo_len);
+                if (bat < MAX_BATS) bat_chromo[bat][chunk] = genes;
+            }
+
+            derive_difference(chromo_buffer, ones, local_vector_cache, total_vector, diff_vec, chromo_len, dim);
+            if (bat < MAX_BATS) {
+                scan_save: for (int d = 0; d < dim; d++) {
+                    #pragma HLS PIPELINE II=1
+                    bat_diff[bat][d] = diff_vec[d];
+                }
+                bat_ones[bat] = ones;
+                bat_valid[bat] = true;
+            }
+
+            // The bat itself, then its neighbors
+            const float fitness = compute_objective(diff_vec, dim, objective);
+            if (pack_results) {
+                record_put(record_stream, beat, fill, fitness, bat, ones);
+            } else {
+                result_stream.write(fitness);
+            }
+            if (emit_diff) emit_difference(result_stream, diff_vec, dim);
+
+            // unroll dims of every flip per cycle: D -/+ 2v reduced to the
+            // block's squares, magnitudes and peak, added to the flip's partials
+            scan_blocks: for (int d_block = 0; d_block < dim; d_block += unroll) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=max_dim/unroll
+                scan_flips: for (int gene = 0; gene < chromo_len; gene++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=max_genes
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=flip_squares inter false
+                    #pragma HLS DEPENDENCE variable=flip_abs inter false
+                    #pragma HLS DEPENDENCE variable=flip_max inter false
+                    const bool old_bit = chromo_buffer[gene / chunk_bits][gene % chunk_bits];
+                    float block_squares = 0.0f;
+                    float block_abs = 0.0f;
+                    float block_max = 0.0f;
+
+                    flip_lanes: for (int lane = 0; lane < unroll; lane++) {
+                        #pragma HLS UNROLL
+                        const int d = d_block + lane;
+                        if (d < dim) {
+                            acc_t vector_val = store::widen(local_vector_cache[cache_index(gene, d, dim)]);
+                            acc_t twice_val = vector_val + vector_val;
+                            float diff = static_cast<float>(old_bit ? acc_t(diff_vec[d] + twice_val)
+                                                                    : acc_t(diff_vec[d] - twice_val));
+                            float magnitude = hls::fabs(diff);
+                            block_squares += diff * diff;
+                            block_abs += magnitude;
+                            if (magnitude > block_max) block_max = magnitude;
+                        }
+                    }
+
+                    const bool first = d_block == 0;
+                    flip_squares[gene] = (first ? 0.0f : flip_squares[gene]) + block_squares;
+                    flip_abs[gene] = (first ? 0.0f : flip_abs[gene]) + block_abs;
+                    const float peak = first ? 0.0f : flip_max[gene];
+                    flip_max[gene] = block_max > peak ? block_max : peak;
+                }
+            }
+
+            topk_reset(best_fitness, best_gene, best_ones);
+            scan_pick: for (int gene = 0; gene < chromo_len; gene++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=max_genes
+                #pragma HLS PIPELINE II=1
+                const bool old_bit = chromo_buffer[gene / chunk_bits][gene % chunk_bits];
+                const float neighbor_fitness = objective == OBJ_MAX_ABS ? flip_max[gene]
+                                             : objective == OBJ_SUM_ABS ? flip_abs[gene]
+                                                                        : flip_squares[gene];
+                const int neighbor_ones = old_bit ? ones - 1 : ones + 1;
+
+                if (top_slots > 0) {
+                    topk_insert(best_fitness, best_gene, best_ones, neighbor_fitness, gene, neighbor_ones,
+                                top_slots);
+                } else if (pack_results) {
+                    record_put(record_stream, beat, fill, neighbor_fitness, gene, neighbor_ones);
+                } else {
+                    result_stream.write(neighbor_fitness);
+                }
+            }
+            if (top_slots > 0) {
+                topk_emit(result_stream, record_stream, beat, fill, pack_results, best_fitness, best_gene,
+                          best_ones, top_slots);
+            }
+        }
+
+        if (pack_results) record_flush(record_stream, beat, fill);
+    }
+
+    // --- MODE DISPATCH ---
+    // Every mode except the loads and MODE_SWAP, run against the active bank.
+    // Unknown modes do nothing, as unpack_beats forwards them no records.
+    static void serve(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        chunk_t* best_chromo_out,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int mode,
+        int objective,
+        bool emit_diff,
+        float prune_threshold,
+        int top_k,
+        int num_generations,
+        int walk_flips,
+        bool pack_results,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        velocity_t bat_velocity[ENGINE_MAX_BATS][max_genes],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        acc_t memo_diff[MEMO_ENTRIES][max_dim],
+        unsigned int memo_count[2]
+    ) {
+        const int top_slots = top_k > TOPK_MAX ? TOPK_MAX : top_k;
+
+        // --- MODE 2 / 7: INCREMENTAL FLIP LIST / RANDOM WALK ---
+        // Per bat the stream carries a flip count followed by that many gene
+        // indices (one chunk_t each); MODE_WALK instead flips walk_flips genes
+        // drawn from the RNG bank. Only the flipped genes are touched, so a
+        // bat costs O(flips * dim) instead of O(chromo_len * dim). Indices
+        // outside [0, chromo_len) are skipped; bats from MAX_BATS on have no
+        // resident state, so their lists are consumed and they report
+        // PRUNED_FITNESS.
+        if (mode == MODE_INCREMENTAL || mode == MODE_WALK) {
+            const bool walk = mode == MODE_WALK;
+            acc_t diff_vec[max_dim];
+            #pragma HLS ARRAY_PARTITION variable=diff_vec cyclic factor=unroll
+
+            float walk_fitness = 0.0f;
+            int walk_bat = -1;
+
+            float best_fitness[TOPK_MAX];
+            int best_bat[TOPK_MAX];
+            int best_ones[TOPK_MAX];
+            #pragma HLS ARRAY_PARTITION variable=best_fitness complete
+            #pragma HLS ARRAY_PARTITION variable=best_bat complete
+            #pragma HLS ARRAY_PARTITION variable=best_ones complete
+            topk_reset(best_fitness, best_bat, best_ones);
+
+            result_beat_t beat = 0;
+            int fill = 0;
+
+            incremental_batches: for (int bat = 0; bat < num_bats; bat++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATS
+
+                const bool resident = bat < MAX_BATS;
+
+                // A bat pruned by its last evaluation has no resident
+                // difference; rebuild it from the resident chromosome
+                if (!resident) {
+                    clear_diff: for (int d = 0; d < dim; d++) {
+                        #pragma HLS PIPELINE II=1
+                        diff_vec[d] = 0;
+                    }
+                } else if (bat_valid[bat]) {
+                    restore_diff: for (int d = 0; d < dim; d++) {
+                        #pragma HLS PIPELINE II=1
+                        diff_vec[d] = bat_diff[bat][d];
+                    }
+                } else {
+                    derive_difference(bat_chromo[bat], bat_ones[bat], local_vector_cache, total_vector, diff_vec,
+                                      chromo_len, dim);
+                }
+
+                int num_flips = walk ? walk_flips : chromosome_stream.read().to_int();
+                int ones = resident ? bat_ones[bat] : 0;
+
+                apply_flips: for (int f = 0; f < num_flips; f++) {
+                    #pragma HLS LOOP_TRIPCOUNT min=1 max=32
+                    #pragma HLS PIPELINE II=1
+                    #pragma HLS DEPENDENCE variable=rng_state inter distance=RNG_LANES true
+
+                    int gene_idx = walk ? random_gene(rng_state[f % RNG_LANES], chromo_len)
+                                        : chromosome_stream.read().to_int();
+                    if (!resident || gene_idx < 0 || gene_idx >= chromo_len) continue;
+                    int chunk_idx = gene_idx / chunk_bits;
+                    int bit_idx = gene_idx % chunk_bits;
+                    bool old_bit = bat_chromo[bat][chunk_idx][bit_idx];
+                    bat_chromo[bat][chunk_idx][bit_idx] = !old_bit;
+                    ones += old_bit ? -1 : 1;
+                    flip_difference(diff_vec, diff_vec, local_vector_cache, gene_idx, old_bit, dim);
+                }
+
+                if (resident) {
+                    save_diff: for (int d = 0; d < dim; d++) {
+                        #pragma HLS PIPELINE II=1
+                        bat_diff[bat][d] = diff_vec[d];
+                    }
+                    bat_ones[bat] = ones;
+                    bat_valid[bat] = true;
+                }
+
+                float fitness = resident ? compute_objective(diff_vec, dim, objective) : PRUNED_FITNESS;
+                if (resident && (walk_bat < 0 || fitness < walk_fitness)) {
+                    walk_fitness = fitness;
+                    walk_bat = bat;
+                }
+                if (top_slots > 0) {
+                    if (resident) topk_insert(best_fitness, best_bat, best_ones, fitness, bat, ones, top_slots);
+                } else {
+                    if (pack_results) {
+                        record_put(record_stream, beat, fill, fitness, bat, ones);
+                    } else {
+                        result_stream.write(fitness);
+                    }
+                    if (emit_diff) emit_difference(result_stream, diff_vec, dim);
+                }
+            }
+
+            if (top_slots > 0) {
+                topk_emit(result_stream, record_stream, beat, fill, pack_results, best_fitness, best_bat,
+                          best_ones, top_slots);
+            }
+            if (pack_results) record_flush(record_stream, beat, fill);
+            if (walk) write_resident(best_chromo_out, bat_chromo, walk_bat, chromo_len);
+        }
+        // --- MODE 5: ON-CHIP BAT ALGORITHM ---
+        else if (mode == MODE_BAT) {
+            run_bat_engine(chromosome_stream, result_stream, best_chromo_out, local_vector_cache,
+                           total_vector, bat_chromo, bat_ones, bat_diff, bat_valid, bat_velocity, chromo_len,
+                           dim, num_bats, objective, emit_diff, rng_state, num_generations);
+        }
+        // --- MODE 9: ONE-FLIP NEIGHBORHOOD SCAN ---
+        else if (mode == MODE_SCAN) {
+            scan_neighbors(chromosome_stream, result_stream, record_stream, local_vector_cache, total_vector,
+                           bat_chromo, bat_ones, bat_diff, bat_valid, chromo_len, dim, num_bats, objective,
+                           emit_diff, top_slots, pack_results);
+        }
+        // --- MODE 4: OUT-OF-CORE STREAMING ---
+        else if (mode == MODE_STREAM) {
+            evaluate_out_of_core(chromosome_stream, result_stream, record_stream, vectors_in,
+                                 chromo_len, dim, num_bats, objective, emit_diff, top_slots, pack_results);
+        }
+        // --- MODE 0 / 6: COMPUTE FITNESS / RANDOM RESTARTS ---
+        else if (mode == MODE_COMPUTE || mode == MODE_RANDOM) {
+            const bool generate = mode == MODE_RANDOM;
+            int best_resident = -1;
+            const float prune_limit = objective == OBJ_MAX_ABS ? prune_threshold : 0.0f;
+            if (dim_major) {
+                evaluate_transposed(chromosome_stream, result_stream, local_vector_cache, total_vector,
+                                    prefix_total, suffix_abs, record_stream, bat_chromo, bat_ones, bat_diff,
+                                    bat_valid, rng_state, memo_key, memo_valid, memo_diff, memo_count, generate,
+                                    chromo_len, dim, num_bats, objective, emit_diff, prune_limit, top_slots,
+                                    pack_results, best_resident);
+            } else {
+                evaluate_population(chromosome_stream, result_stream, local_vector_cache, total_vector,
+                                    prefix_total, suffix_abs, record_stream, bat_chromo, bat_ones, bat_diff,
+                                    bat_valid, rng_state, memo_key, memo_valid, memo_diff, memo_count, generate,
+                                    chromo_len, dim, num_bats, objective, emit_diff, prune_limit, top_slots,
+                                    pack_results, best_resident);
+            }
+            if (generate) write_resident(best_chromo_out, bat_chromo, best_resident, chromo_len);
+        }
+    }
+
+    // serve() on the active bank alongside a preload of the shadow bank from
+    // vectors_wide. The two share no storage or ports, so they overlap.
+    static void serve_and_preload(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        chunk_t* best_chromo_out,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int mode,
+        int objective,
+        bool emit_diff,
+        float prune_threshold,
+        int top_k,
+        int num_generations,
+        int walk_flips,
+        bool pack_results,
+        const store_t local_vector_cache[cache_size],
+        const sum_t total_vector[max_dim],
+        const acc_t prefix_total[prune_segments + 1][max_dim],
+        const acc_t suffix_abs[prune_segments + 1][max_dim],
+        chunk_t bat_chromo[MAX_BATS][max_chunks],
+        int bat_ones[MAX_BATS],
+        acc_t bat_diff[MAX_BATS][max_dim],
+        bool bat_valid[MAX_BATS],
+        velocity_t bat_velocity[ENGINE_MAX_BATS][max_genes],
+        unsigned int rng_state[RNG_LANES][4],
+        chunk_t memo_key[MEMO_ENTRIES][max_chunks],
+        bool memo_valid[MEMO_ENTRIES],
+        acc_t memo_diff[MEMO_ENTRIES][max_dim],
+        unsigned int memo_count[2],
+        const wide_t* vectors_wide,
+        int preload_len,
+        int preload_dim,
+        store_t shadow_cache[cache_size],
+        sum_t shadow_total[max_dim],
+        acc_t shadow_prefix[prune_segments + 1][max_dim],
+        acc_t shadow_suffix[prune_segments + 1][max_dim]
+    ) {
+        #pragma HLS DATAFLOW
+
+        serve(chromosome_stream, result_stream, record_stream, vectors_in, best_chromo_out, chromo_len, dim,
+              num_bats, mode, objective, emit_diff, prune_threshold, top_k, num_generations, walk_flips,
+              pack_results, local_vector_cache, total_vector, prefix_total, suffix_abs, bat_chromo, bat_ones,
+              bat_diff, bat_valid, bat_velocity, rng_state, memo_key, memo_valid, memo_diff, memo_count);
+        load_bank(0, vectors_wide, true, shadow_cache, shadow_total, shadow_prefix, shadow_suffix,
+                  preload_len, preload_dim);
+    }
+
+    // --- WIDE CHROMOSOME INPUT ---
+    // CHROMO_BEAT_CHUNKS chunk_t words per beat, word 0 in the low bits
+    typedef ap_uint<chunk_bits * CHROMO_BEAT_CHUNKS> beat_t;
+
+    // Split beats back into the chunk_t words run() reads. Every bat's record
+    // (its chunks, or a flip count plus indices) starts on a fresh beat, so
+    // the word count per bat fixes how many beats to take.
+    static void unpack_beats(
+        hls::stream<beat_t>& beat_stream,
+        hls::stream<chunk_t>& chromosome_stream,
+        int chromo_len,
+        int num_bats,
+        int mode
+    ) {
+        const int num_chunks = (chromo_len + chunk_bits - 1) / chunk_bits;
+        const bool flip_lists = mode == MODE_INCREMENTAL;
+        int records = 0;
+        if (mode == MODE_COMPUTE || mode == MODE_STREAM || mode == MODE_SCAN || mode == MODE_BAT || flip_lists) {
+            records = num_bats;
+        }
+
+        unpack_records: for (int rec = 0; rec < records; rec++) {
+            #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATS
+            int words = flip_lists ? 1 : num_chunks;
+            beat_t beat = 0;
+
+            unpack_words: for (int w = 0; w < words; w++) {
+                #pragma HLS LOOP_TRIPCOUNT min=1 max=max_chunks
+                #pragma HLS PIPELINE II=1
+                const int slot = w % CHROMO_BEAT_CHUNKS;
+                if (slot == 0) beat = beat_stream.read();
+                chunk_t word = beat.range(slot * chunk_bits + chunk_bits - 1, slot * chunk_bits);
+                // A flip list's first word is its length
+                if (flip_lists && w == 0) words = 1 + word.to_int();
+                chromosome_stream.write(word);
+            }
+        }
+    }
+
+public:
+    // Body of every named top; the caller supplies the INTERFACE pragmas
+    static void run(
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        const wide_t* vectors_wide,
+        chunk_t* best_chromo_out,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int mode,
+        int objective,
+        bool emit_diff,
+        float prune_threshold,
+        int top_k,
+        int num_generations,
+        unsigned int rng_seed,
+        int walk_flips,
+        int preload_len,
+        int preload_dim,
+        bool pack_results,
+        unsigned int* memo_lookups,
+        unsigned int* memo_hits
+    ) {
+        // --- LOCAL STORAGE ---
+        // cache_copies cache banks. With ping-pong, modes run against
+        // active_bank while the other one is loaded; otherwise active_bank
+        // stays 0. Each bank carries its own total and bounds.
+        static store_t local_vector_cache[cache_copies][cache_size];
+        #pragma HLS ARRAY_PARTITION variable=local_vector_cache complete dim=1
+#ifdef FITNESS_CACHE_URAM
+        #pragma HLS ARRAY_RESHAPE variable=local_vector_cache cyclic factor=cache_banks dim=2
+#else
+        #pragma HLS ARRAY_PARTITION variable=local_vector_cache cyclic factor=cache_banks dim=2
+#endif
+        #pragma HLS BIND_STORAGE variable=local_vector_cache type=ram_2p impl=CACHE_IMPL
+        static ap_uint<1> active_bank = 0;
+
+        // Total vector T = sum of all gene vectors, rebuilt by every cache load.
+        // With it only one side of the partition has to be accumulated:
+        // sumA - sumB = T - 2*sumB = 2*sumA - T.
+        static sum_t total_vector[cache_copies][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=total_vector complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=total_vector cyclic factor=unroll dim=2
+
+        // Per-bat state kept between calls for MODE_INCREMENTAL. Written by every
+        // MODE_COMPUTE evaluation of bats [0, MAX_BATS).
+        static chunk_t bat_chromo[MAX_BATS][max_chunks];
+        static int bat_ones[MAX_BATS];
+        static acc_t bat_diff[MAX_BATS][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=bat_diff cyclic factor=unroll dim=2
+        // bat_diff[bat] matches bat_chromo[bat]; cleared for pruned bats
+        static bool bat_valid[MAX_BATS];
+
+        // Pruning bounds at every PRUNE_INTERVAL-gene checkpoint s: the total of
+        // genes [0, s*PRUNE_INTERVAL) and the absolute mass of the genes after it
+        static acc_t prefix_total[cache_copies][prune_segments + 1][max_dim];
+        static acc_t suffix_abs[cache_copies][prune_segments + 1][max_dim];
+        #pragma HLS ARRAY_PARTITION variable=prefix_total complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=prefix_total cyclic factor=unroll dim=3
+        #pragma HLS ARRAY_PARTITION variable=suffix_abs complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=suffix_abs cyclic factor=unroll dim=3
+
+        // Per-gene velocities of the MODE_BAT population
+        static velocity_t bat_velocity[ENGINE_MAX_BATS][max_genes];
+
+        // RNG bank, reseeded by every call with a nonzero rng_seed and
+        // otherwise continuing where the previous call stopped
+        static unsigned int rng_state[RNG_LANES][4];
+        static bool rng_seeded = false;
+        #pragma HLS ARRAY_PARTITION variable=rng_state complete dim=0
+
+        // Duplicate filter of MODE_COMPUTE / MODE_RANDOM. It describes the
+        // active bank at one shape, so loads, swaps and shape changes clear it.
+        static chunk_t memo_key[MEMO_ENTRIES][max_chunks];
+        static bool memo_valid[MEMO_ENTRIES];
+        static acc_t memo_diff[MEMO_ENTRIES][max_dim];
+        static unsigned int memo_count[2];
+        static int memo_len = 0;
+        static int memo_dim = 0;
+        #pragma HLS ARRAY_PARTITION variable=memo_key complete dim=1
+        #pragma HLS ARRAY_PARTITION variable=memo_valid complete
+        #pragma HLS ARRAY_PARTITION variable=memo_diff cyclic factor=unroll dim=2
+        #pragma HLS ARRAY_PARTITION variable=memo_count complete
+
+        // One shared instance behind both bank orders
+        #pragma HLS ALLOCATION function instances=load_bank limit=1
+        #pragma HLS ALLOCATION function instances=serve_and_preload limit=1
+
+        if (rng_seed != 0 || !rng_seeded) {
+            rng_seed_bank(rng_state, rng_seed);
+            rng_seeded = true;
+        }
+
+        const bool evaluates = mode == MODE_COMPUTE || mode == MODE_RANDOM;
+        if (mode == MODE_SWAP || mode == MODE_LOAD || mode == MODE_LOAD_WIDE ||
+            (evaluates && (chromo_len != memo_len || dim != memo_dim))) {
+            memo_clear: for (int e = 0; e < MEMO_ENTRIES; e++) {
+                #pragma HLS UNROLL
+                memo_valid[e] = false;
+            }
+            memo_count[count_lookups] = 0;
+            memo_count[count_hits] = 0;
+            memo_len = chromo_len;
+            memo_dim = dim;
+        }
+
+        // --- MODE 8: SWAP BANKS ---
+        if (mode == MODE_SWAP) {
+            if (ping_pong) active_bank = ~active_bank;
+            result_stream.write(0.0f);
+        }
+        // --- MODE 1 / 3: LOAD CACHE ---
+        // Loads fill the shadow bank and swap it in. An empty load leaves the
+        // shadow bank as it was, so it must not become active.
+        else if (mode == MODE_LOAD || mode == MODE_LOAD_WIDE) {
+            const bool wide = mode == MODE_LOAD_WIDE;
+            if (active_bank == 0) {
+                load_bank(vectors_in, vectors_wide, wide, local_vector_cache[shadow_copy],
+                          total_vector[shadow_copy], prefix_total[shadow_copy], suffix_abs[shadow_copy],
+                          chromo_len, dim);
+            } else {
+                load_bank(vectors_in, vectors_wide, wide, local_vector_cache[0], total_vector[0],
+                          prefix_total[0], suffix_abs[0], chromo_len, dim);
+            }
+            if (ping_pong && chromo_len > 0) active_bank = ~active_bank;
+            result_stream.write(0.0f);
+        }
+        // --- ALL OTHER MODES, PRELOADING THE SHADOW BANK ---
+        else if (!ping_pong) {
+            serve(chromosome_stream, result_stream, record_stream, vectors_in, best_chromo_out, chromo_len, dim,
+                  num_bats, mode, objective, emit_diff, prune_threshold, top_k, num_generations, walk_flips,
+                  pack_results, local_vector_cache[0], total_vector[0], prefix_total[0], suffix_abs[0],
+                  bat_chromo, bat_ones, bat_diff, bat_valid, bat_velocity, rng_state, memo_key, memo_valid,
+                  memo_diff, memo_count);
+        } else if (active_bank == 0) {
+            serve_and_preload(chromosome_stream, result_stream, record_stream, vectors_in, best_chromo_out,
+                              chromo_len, dim, num_bats, mode, objective, emit_diff, prune_threshold, top_k,
+                              num_generations, walk_flips, pack_results, local_vector_cache[0], total_vector[0],
+                              prefix_total[0], suffix_abs[0], bat_chromo, bat_ones, bat_diff, bat_valid,
+                              bat_velocity, rng_state, memo_key, memo_valid, memo_diff, memo_count, vectors_wide,
+                              preload_len, preload_dim, local_vector_cache[shadow_copy], total_vector[shadow_copy],
+                              prefix_total[shadow_copy], suffix_abs[shadow_copy]);
+        } else {
+            serve_and_preload(chromosome_stream, result_stream, record_stream, vectors_in, best_chromo_out,
+                              chromo_len, dim, num_bats, mode, objective, emit_diff, prune_threshold, top_k,
+                              num_generations, walk_flips, pack_results, local_vector_cache[shadow_copy],
+                              total_vector[shadow_copy], prefix_total[shadow_copy], suffix_abs[shadow_copy],
+                              bat_chromo, bat_ones, bat_diff, bat_valid, bat_velocity, rng_state, memo_key,
+                              memo_valid, memo_diff, memo_count, vectors_wide, preload_len, preload_dim,
+                              local_vector_cache[0], total_vector[0], prefix_total[0], suffix_abs[0]);
+        }
+
+        *memo_lookups = memo_count[count_lookups];
+        *memo_hits = memo_count[count_hits];
+    }
+
+    // run() fed from a beat stream: unpacking runs as its own process, so a
+    // whole chromosome arrives in num_chunks / CHROMO_BEAT_CHUNKS beats
+    static void run_wide_input(
+        hls::stream<beat_t>& beat_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        const wide_t* vectors_wide,
+        chunk_t* best_chromo_out,
+        int chromo_len,
+        int dim,
+        int num_bats,
+        int mode,
+        int objective,
+        bool emit_diff,
+        float prune_threshold,
+        int top_k,
+        int num_generations,
+        unsigned int rng_seed,
+        int walk_flips,
+        int preload_len,
+        int preload_dim,
+        bool pack_results,
+        unsigned int* memo_lookups,
+        unsigned int* memo_hits
+    ) {
+        #pragma HLS DATAFLOW
+
+        hls::stream<chunk_t> chromosome_stream("chromosome_stream");
+        #pragma HLS STREAM variable=chromosome_stream depth=2*CHROMO_BEAT_CHUNKS
+
+        unpack_beats(beat_stream, chromosome_stream, chromo_len, num_bats, mode);
+        run(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide, best_chromo_out,
+            chromo_len, dim, num_bats, mode, objective, emit_diff, prune_threshold, top_k, num_generations,
+            rng_seed, walk_flips, preload_len, preload_dim, pack_results, memo_lookups, memo_hits);
+    }
+
+    // Command loop of the free-running top: the registers of run() become
+    // local state set by CMD_SET_* packets, and CMD_RUN calls run() with it.
+    // Returns on CMD_HALT.
+    static void run_commands(
+        hls::stream<packed_t>& command_stream,
+        hls::stream<chunk_t>& chromosome_stream,
+        hls::stream<float>& result_stream,
+        hls::stream<result_beat_t>& record_stream,
+        const float* vectors_in,
+        const wide_t* vectors_wide,
+        chunk_t* best_chromo_out
+    ) {
+        int chromo_len = 0;
+        int dim = 0;
+        int objective = OBJ_SUM_SQUARES;
+        bool emit_diff = false;
+        float prune_threshold = 0.0f;
+        int top_k = 0;
+        int num_generations = 0;
+        int walk_flips = 0;
+        unsigned int rng_seed = 0;
+        int preload_len = 0;
+        int preload_dim = 0;
+        bool pack_results = false;
+        // Filter counters are only published by the register-driven tops
+        unsigned int memo_lookups = 0;
+        unsigned int memo_hits = 0;
+
+        command_loop: while (true) {
+            const int opcode = command_stream.read().to_int();
+            if (opcode == CMD_HALT) break;
+
+            if (opcode == CMD_RUN) {
+                const int mode = command_stream.read().to_int();
+                const int num_bats = command_stream.read().to_int();
+                run(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide, best_chromo_out,
+                    chromo_len, dim, num_bats, mode, objective, emit_diff, prune_threshold, top_k,
+                    num_generations, rng_seed, walk_flips, preload_len, preload_dim, pack_results, &memo_lookups,
+                    &memo_hits);
+                // One-shot settings
+                rng_seed = 0;
+                preload_len = 0;
+                preload_dim = 0;
+            } else if (opcode == CMD_SET_SHAPE) {
+                chromo_len = command_stream.read().to_int();
+                dim = command_stream.read().to_int();
+            } else if (opcode == CMD_SET_OBJECTIVE) {
+                objective = command_stream.read().to_int();
+                emit_diff = command_stream.read() != 0;
+            } else if (opcode == CMD_SET_THRESHOLD) {
+                prune_threshold = bits_to_float(command_stream.read());
+            } else if (opcode == CMD_SET_TOP_K) {
+                top_k = command_stream.read().to_int();
+            } else if (opcode == CMD_SET_SEARCH) {
+                num_generations = command_stream.read().to_int();
+                walk_flips = command_stream.read().to_int();
+            } else if (opcode == CMD_SET_SEED) {
+                rng_seed = command_stream.read().to_uint();
+            } else if (opcode == CMD_SET_PRELOAD) {
+                preload_len = command_stream.read().to_int();
+                preload_dim = command_stream.read().to_int();
+            } else if (opcode == CMD_SET_RECORDS) {
+                pack_results = command_stream.read() != 0;
+            }
+        }
+    }
+};
+
+#endif
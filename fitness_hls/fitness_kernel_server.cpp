@@ -0,0 +1,42 @@
+#include <hls_stream.h>
+#include <ap_int.h>
+#include <hls_math.h>
+#include "fitness_kernel.h"
+#include "fitness_kernel_impl.h"
+
+/* Free-running variant of fitness_kernel. Instead of one AXI-lite
+ * configured call per mode, the kernel starts once (ap_ctrl_none) and
+ * executes CMD_* packets from command_stream back to back. Only the buffer
+ * addresses stay in the control bundle; they are written once at startup.
+ * CMD_HALT returns, and without block-level control the kernel restarts
+ * straight away, so in hardware it serves commands indefinitely. */
+
+extern "C" {
+
+void fitness_server(
+    hls::stream<packed_t>& command_stream,
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=command_stream
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(MAX_GENES*MAX_DIM+WIDE_FLOATS-1)/WIDE_FLOATS max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=MAX_CHUNKS
+    #pragma HLS INTERFACE s_axilite port=vectors_in bundle=control
+    #pragma HLS INTERFACE s_axilite port=vectors_wide bundle=control
+    #pragma HLS INTERFACE s_axilite port=best_chromo_out bundle=control
+    #pragma HLS INTERFACE ap_ctrl_none port=return
+
+    fitness_engine<max_capacity_config>::run_commands(command_stream, chromosome_stream, result_stream,
+                                                      record_stream, vectors_in, vectors_wide, best_chromo_out);
+}
+
+}
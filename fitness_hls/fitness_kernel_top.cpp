@@ -1,42 +1,356 @@
 #include <hls_stream.h>
 #include <ap_int.h>
 #include <hls_math.h>
-#include <stdint.h>
+#include "fitness_kernel.h"
+#include "fitness_kernel_impl.h"
 
-#define MAX_CHROMO 500
-#define MAX_DIM    20
+/* Named variants of fitness_kernel. Same registers, different fitness_config
+ * or chromosome port width; each has its own synthesis target
+ * (hls_config_*.cfg). */
 
 extern "C" {
 
-/* Your original kernel */
-void fitness_kernel(
-    hls::stream<uint8_t> &chromosome_stream,
-    hls::stream<float>   &result_stream,
-    const float          *vectors,
-    int                  chromo_len,
-    int                  dim
-);
-
-/* ================= TOP FUNCTION ================= */
-extern "C" void fitness_top(
-    hls::stream<uint8_t> &chromosome_stream,
-    hls::stream<float>   &result_stream,
-    const float          *vectors,
-    int                  chromo_len,
-    int                  dim
+/* ============ SMALL-DIM / LARGE-N: dim <= 20, up to 5000 genes ============ */
+void fitness_top(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
 ) {
-#pragma HLS INTERFACE ap_ctrl_none port=return
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*SMALL_DIM_MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(SMALL_DIM_MAX_GENES*SMALL_DIM_MAX_DIM+WIDE_FLOATS-1)/WIDE_FLOATS max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=(SMALL_DIM_MAX_GENES+BITS_PER_CHUNK-1)/BITS_PER_CHUNK
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
 
-#pragma HLS INTERFACE axis port=chromosome_stream
-#pragma HLS INTERFACE axis port=result_stream
+    fitness_engine<small_dim_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                          vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                          objective, emit_diff, prune_threshold, top_k, num_generations,
+                                          rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                          memo_lookups, memo_hits);
+}
+
+/* ============ LARGE-DIM / SMALL-N: dim <= 400, up to 250 genes ============ */
+void fitness_top_large_dim(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*LARGE_DIM_MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(LARGE_DIM_MAX_GENES*LARGE_DIM_MAX_DIM+WIDE_FLOATS-1)/WIDE_FLOATS max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=(LARGE_DIM_MAX_GENES+BITS_PER_CHUNK-1)/BITS_PER_CHUNK
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
+
+    fitness_engine<large_dim_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                          vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                          objective, emit_diff, prune_threshold, top_k, num_generations,
+                                          rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                          memo_lookups, memo_hits);
+}
+
+/* ============ MAX-CAPACITY, 256-BIT CHROMOSOME BEATS ============ */
+void fitness_kernel_wide_in(
+    hls::stream<chromo_beat_t>& chromosome_beats,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_beats
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(MAX_GENES*MAX_DIM+WIDE_FLOATS-1)/WIDE_FLOATS max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=MAX_CHUNKS
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
+
+    fitness_engine<max_capacity_config>::run_wide_input(chromosome_beats, result_stream, record_stream,
+                                                        vectors_in, vectors_wide, best_chromo_out, chromo_len,
+                                                        dim, num_bats, mode, objective, emit_diff,
+                                                        prune_threshold, top_k, num_generations, rng_seed,
+                                                        walk_flips, preload_len, preload_dim, pack_results,
+                                                        memo_lookups, memo_hits);
+}
 
-#pragma HLS INTERFACE m_axi     port=vectors offset=slave bundle=gmem_vec depth=10000
-#pragma HLS INTERFACE s_axilite port=vectors    bundle=control
-#pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
-#pragma HLS INTERFACE s_axilite port=dim        bundle=control
+/* ============ BF16 STORAGE: dim <= 100, up to 2000 genes ============ */
+void fitness_top_bf16(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(HALF_STORE_MAX_GENES*MAX_DIM+WIDE_HALVES-1)/WIDE_HALVES max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=(HALF_STORE_MAX_GENES+BITS_PER_CHUNK-1)/BITS_PER_CHUNK
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
+
+    fitness_engine<bf16_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                     vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                     objective, emit_diff, prune_threshold, top_k, num_generations,
+                                     rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                     memo_lookups, memo_hits);
+}
+
+/* ============ FP16 STORAGE: dim <= 100, up to 2000 genes ============ */
+void fitness_top_fp16(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(HALF_STORE_MAX_GENES*MAX_DIM+WIDE_HALVES-1)/WIDE_HALVES max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=(HALF_STORE_MAX_GENES+BITS_PER_CHUNK-1)/BITS_PER_CHUNK
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
+
+    fitness_engine<fp16_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                     vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                     objective, emit_diff, prune_threshold, top_k, num_generations,
+                                     rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                     memo_lookups, memo_hits);
+}
+
+/* ============ URAM CACHE: dim <= 64, up to 10000 genes ============ */
+void fitness_top_uram(
+    hls::stream<packed_t>& chromosome_stream,
+    hls::stream<float>& result_stream,
+    hls::stream<result_beat_t>& record_stream,
+    const float* vectors_in,
+    const wide_t* vectors_wide,
+    packed_t* best_chromo_out,
+    int chromo_len,
+    int dim,
+    int num_bats,
+    int mode,
+    int objective,
+    bool emit_diff,
+    float prune_threshold,
+    int top_k,
+    int num_generations,
+    unsigned int rng_seed,
+    int walk_flips,
+    int preload_len,
+    int preload_dim,
+    bool pack_results,
+    unsigned int* memo_lookups,
+    unsigned int* memo_hits
+) {
+    // --- INTERFACES ---
+    #pragma HLS INTERFACE axis port=chromosome_stream
+    #pragma HLS INTERFACE axis port=result_stream
+    #pragma HLS INTERFACE axis port=record_stream
+    #pragma HLS INTERFACE m_axi port=vectors_in offset=slave bundle=gmem_vec depth=OOC_MAX_GENES*URAM_MAX_DIM
+    #pragma HLS INTERFACE m_axi port=vectors_wide offset=slave bundle=gmem_wide depth=(URAM_MAX_GENES*URAM_MAX_DIM+WIDE_HALVES-1)/WIDE_HALVES max_read_burst_length=64 num_read_outstanding=16
+    #pragma HLS INTERFACE m_axi port=best_chromo_out offset=slave bundle=gmem_best depth=(URAM_MAX_GENES+BITS_PER_CHUNK-1)/BITS_PER_CHUNK
+    #pragma HLS INTERFACE s_axilite port=chromo_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_bats bundle=control
+    #pragma HLS INTERFACE s_axilite port=mode bundle=control
+    #pragma HLS INTERFACE s_axilite port=objective bundle=control
+    #pragma HLS INTERFACE s_axilite port=emit_diff bundle=control
+    #pragma HLS INTERFACE s_axilite port=prune_threshold bundle=control
+    #pragma HLS INTERFACE s_axilite port=top_k bundle=control
+    #pragma HLS INTERFACE s_axilite port=num_generations bundle=control
+    #pragma HLS INTERFACE s_axilite port=rng_seed bundle=control
+    #pragma HLS INTERFACE s_axilite port=walk_flips bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_len bundle=control
+    #pragma HLS INTERFACE s_axilite port=preload_dim bundle=control
+    #pragma HLS INTERFACE s_axilite port=pack_results bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_lookups bundle=control
+    #pragma HLS INTERFACE s_axilite port=memo_hits bundle=control
+    #pragma HLS INTERFACE s_axilite port=return bundle=control
 
-    /* Call your kernel */
-    fitness_kernel(chromosome_stream, result_stream, vectors, chromo_len, dim);
+    fitness_engine<uram_config>::run(chromosome_stream, result_stream, record_stream, vectors_in,
+                                     vectors_wide, best_chromo_out, chromo_len, dim, num_bats, mode,
+                                     objective, emit_diff, prune_threshold, top_k, num_generations,
+                                     rng_seed, walk_flips, preload_len, preload_dim, pack_results,
+                                     memo_lookups, memo_hits);
 }
 
 } // extern "C"
@@ -15,6 +15,27 @@
 
 typedef ap_uint<32> packed_t;
 
+#ifdef FITNESS_ACC_FIXED
+// Fixed-point accumulation on integer coordinates must be bit-exact
+const bool exact_mode = true;
+#else
+const bool exact_mode = false;
+#endif
+
+#ifdef FITNESS_ACC_COMPENSATED
+const char* const acc_mode_name = "compensated float (TwoSum)";
+// Adders on the accumulate path of one gene step: TwoSum plus the lo update
+const int acc_path_adds = 7;
+#elif defined(FITNESS_ACC_FIXED)
+const char* const acc_mode_name = "fixed-point (exact check)";
+const int acc_path_adds = 1;
+#else
+const char* const acc_mode_name = "float";
+const int acc_path_adds = 1;
+#endif
+// Latency of one float adder at the target clock, for the cost model of TEST 19
+const int fadd_latency = 4;
+
 // Helper function to generate random float
 float random_float(float min = -1.0f, float max = 1.0f) {
     return min + static_cast<float>(rand()) / 
@@ -36,8 +57,24 @@ packed_t generate_random_chunk(int chunk_idx, int chromo_len) {
     return chunk;
 }
 
-// Reference CPU implementation for verification - using double precision intermediate
-float cpu_reference_double(
+// Copy of `chromosomes` (chromo_len genes each) with random bits in the
+// padding past chromo_len, which the kernel must ignore
+std::vector<packed_t> with_padding(const std::vector<packed_t>& chromosomes, int chromo_len) {
+    const int num_chunks = (chromo_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<packed_t> padded(chromosomes);
+    for (size_t i = 0; i < padded.size(); i++) {
+        for (int bit = 0; bit < BITS_PER_CHUNK; bit++) {
+            int gene_idx = static_cast<int>(i % num_chunks) * BITS_PER_CHUNK + bit;
+            if (gene_idx >= chromo_len && (rand() % 2) == 1) {
+                padded[i].set_bit(bit, 1);
+            }
+        }
+    }
+    return padded;
+}
+
+// Reference sumA - sumB per dimension, in double precision
+std::vector<double> cpu_difference_double(
     const std::vector<float>& vectors,
     const std::vector<packed_t>& chromosome,
     int chromo_len,
@@ -66,16 +103,50 @@ float cpu_reference_double(
         }
     }
     
+    std::vector<double> diff_vec(dim);
+    for (int d = 0; d < dim; d++) {
+        diff_vec[d] = sumA[d] - sumB[d];
+    }
+    return diff_vec;
+}
+
+// Reference CPU implementation for verification - using double precision intermediate
+float cpu_reference_double(
+    const std::vector<float>& vectors,
+    const std::vector<packed_t>& chromosome,
+    int chromo_len,
+    int dim,
+    int objective = OBJ_SUM_SQUARES
+) {
+    std::vector<double> diff_vec = cpu_difference_double(vectors, chromosome, chromo_len, dim);
+    
     double total_dist = 0.0;
     for (int d = 0; d < dim; d++) {
-        double diff = sumA[d] - sumB[d];
-        total_dist += diff * diff;
+        double diff = diff_vec[d];
+        if (objective == OBJ_MAX_ABS) total_dist = fmax(total_dist, fabs(diff));
+        else if (objective == OBJ_SUM_ABS) total_dist += fabs(diff);
+        else total_dist += diff * diff;
     }
     
     // Return as float to match HLS
     return static_cast<float>(total_dist);
 }
 
+// Pack vectors for a 16-bit storage variant (H = bf16_t or fp16_t),
+// WIDE_HALVES values per 512-bit beat, and return in `rounded` the values
+// its cache ends up holding
+template <typename H>
+std::vector<wide_t> pack_halves(const std::vector<float>& vectors, std::vector<float>& rounded) {
+    std::vector<wide_t> beats((vectors.size() + WIDE_HALVES - 1) / WIDE_HALVES, wide_t(0));
+    rounded.resize(vectors.size());
+    for (size_t i = 0; i < vectors.size(); i++) {
+        H value = H::from_float(vectors[i]);
+        rounded[i] = value.to_float();
+        beats[i / WIDE_HALVES].range(16 * (i % WIDE_HALVES) + 15, 16 * (i % WIDE_HALVES)) = value.bits;
+    }
+    return beats;
+}
+
 // Helper function to compare floating-point values with tolerance
 bool compare_floats(float a, float b, float& diff, float& rel_error) {
     diff = fabs(a - b);
@@ -94,6 +165,83 @@ bool compare_floats(float a, float b, float& diff, float& rel_error) {
     }
 }
 
+// Drain result_stream and compare each value against the double-precision
+// reference for the matching chromosome. Returns the number of significant errors.
+int verify_results(
+    hls::stream<float>& result_stream,
+    const std::vector<float>& vectors_vec,
+    const std::vector<packed_t>& chromosome_data,
+    int chromo_len,
+    int dim,
+    int& results_received,
+    float& max_abs_error,
+    float& max_rel_error,
+    int objective = OBJ_SUM_SQUARES
+) {
+    const int num_chunks = (chromo_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    int errors = 0;
+    results_received = 0;
+
+    // Read results from stream
+    while (!result_stream.empty()) {
+        float hw_result = result_stream.read();
+    
+        // Compute CPU reference for this batch using double precision intermediate
+        std::vector<packed_t> batch_chromosome(
+            chromosome_data.begin() + (results_received * num_chunks),
+            chromosome_data.begin() + ((results_received + 1) * num_chunks)
+        );
+    
+        float cpu_result = cpu_reference_double(
+            vectors_vec,
+            batch_chromosome,
+            chromo_len,
+            dim,
+            objective
+        );
+    
+        // Compare results with intelligent tolerance
+        float diff, rel_error;
+        bool match = compare_floats(hw_result, cpu_result, diff, rel_error);
+        if (exact_mode) match = (hw_result == cpu_result);
+    
+        // Update max errors
+        if (diff > max_abs_error) max_abs_error = diff;
+        if (rel_error > max_rel_error) max_rel_error = rel_error;
+    
+        std::cout << "  Batch " << results_received << ":\n";
+        std::cout << "    HW result:  " << hw_result << "\n";
+        std::cout << "    CPU result: " << cpu_result << "\n";
+        std::cout << "    Difference: " << diff << "\n";
+        std::cout << "    Rel error:  " << (rel_error * 100) << "%\n";
+    
+        // Analyze the error pattern
+        if (diff > 0) {
+            // Check if error is a power of 2 (common in floating-point rounding)
+            float log2_diff = log2f(diff);
+            float rounded_log2 = roundf(log2_diff);
+            if (fabs(log2_diff - rounded_log2) < 0.1f) {
+                std::cout << "    Error type: Power of 2 rounding (2^" << rounded_log2 << ")\n";
+            }
+        }
+    
+        if (!match) {
+            std::cout << "    [WARNING: Small numerical difference]\n";
+            // Only count as error if it's significant
+            if (exact_mode || diff > 0.1f || rel_error > 0.001f) {  // 0.1 absolute or 0.1% relative
+                std::cout << "    [ERROR: Significant mismatch!]\n";
+                errors++;
+            }
+        } else {
+            std::cout << "    [OK]\n";
+        }
+    
+        results_received++;
+    }
+
+    return errors;
+}
+
 int main() {
     std::cout << "========================================\n";
     std::cout << "   Fitness Kernel Testbench (Updated)\n";
@@ -112,19 +260,33 @@ int main() {
     std::cout << "  chromo_len: " << chromo_len << "\n";
     std::cout << "  dim: " << dim << "\n";
     std::cout << "  num_bats: " << num_bats << "\n";
-    std::cout << "  num_chunks: " << num_chunks << "\n\n";
+    std::cout << "  num_chunks: " << num_chunks << "\n";
+    std::cout << "  accumulator: " << acc_mode_name << "\n\n";
     
     // Create streams
     hls::stream<packed_t> chromosome_stream;
     hls::stream<float> result_stream;
+    hls::stream<result_beat_t> record_stream;
+    unsigned int memo_lookups = 0;
+    unsigned int memo_hits = 0;
     
     // Allocate and initialize vectors
     std::cout << "Initializing vectors...\n";
     float* vectors_in = new float[chromo_len * dim];
     for (int i = 0; i < chromo_len * dim; i++) {
-        vectors_in[i] = random_float(-10.0f, 10.0f);
+        if (exact_mode) {
+            // Integer coordinates: exactly representable in acc_t
+            vectors_in[i] = static_cast<float>(rand() % 21 - 10);
+        } else {
+            vectors_in[i] = random_float(-10.0f, 10.0f);
+        }
     }
     
+    // Same instance size in 512-bit beats for the wide loader (TEST 4)
+    const int num_beats = (chromo_len * dim + WIDE_FLOATS - 1) / WIDE_FLOATS;
+    wide_t* vectors_wide = new wide_t[num_beats];
+    std::vector<packed_t> best_chromo(MAX_CHUNKS);
+    
     // Generate chromosome data for reference
     std::vector<packed_t> chromosome_data;
     for (int bat = 0; bat < num_bats; bat++) {
@@ -140,11 +302,26 @@ int main() {
     fitness_kernel(
         chromosome_stream,  // Empty stream for cache loading
         result_stream,
+        record_stream,
         vectors_in,
+        vectors_wide,
+        best_chromo.data(),
         chromo_len,
         dim,
         num_bats,           // num_bats parameter is ignored in mode=1
-        true                // mode = 1 (load cache)
+        MODE_LOAD,          // mode = 1 (load cache)
+        OBJ_SUM_SQUARES,
+        false,
+        0.0f,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        false,
+        &memo_lookups,
+        &memo_hits
     );
     
     // Read completion signal
@@ -154,6 +331,7 @@ int main() {
     } else {
         std::cout << "  ERROR: No completion signal received!\n";
         delete[] vectors_in;
+        delete[] vectors_wide;
         return 1;
     }
     
@@ -170,11 +348,26 @@ int main() {
     fitness_kernel(
         chromosome_stream,
         result_stream,
+        record_stream,
         vectors_in,
+        vectors_wide,
+        best_chromo.data(),
         chromo_len,
         dim,
         num_bats,
-        false               // mode = 0 (compute fitness)
+        MODE_COMPUTE,       // mode = 0 (compute fitness)
+        OBJ_SUM_SQUARES,
+        false,
+        0.0f,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        false,
+        &memo_lookups,
+        &memo_hits
     );
     
     // ==== VERIFICATION ====
@@ -183,65 +376,1611 @@ int main() {
     // Convert vectors to std::vector for CPU reference
     std::vector<float> vectors_vec(vectors_in, vectors_in + chromo_len * dim);
     
-    int errors = 0;
     int results_received = 0;
     float max_abs_error = 0.0f;
     float max_rel_error = 0.0f;
     
-    // Read results from stream
-    while (!result_stream.empty()) {
+    int errors = verify_results(result_stream, vectors_vec, chromosome_data,
+                                chromo_len, dim, results_received,
+                                max_abs_error, max_rel_error);
+    
+    // ==== TEST 3: INCREMENTAL FLIP LISTS ====
+    std::cout << "\n[TEST 3] Applying flip lists (mode=2)...\n";
+    
+    // Flip a few random genes per bat and stream only their indices
+    for (int bat = 0; bat < num_bats; bat++) {
+        int num_flips = 1 + bat;
+        chromosome_stream.write(packed_t(num_flips));
+        for (int f = 0; f < num_flips; f++) {
+            int gene_idx = rand() % chromo_len;
+            packed_t& chunk = chromosome_data[bat * num_chunks + gene_idx / BITS_PER_CHUNK];
+            int bit = gene_idx % BITS_PER_CHUNK;
+            chunk.set_bit(bit, !chunk[bit]);
+            chromosome_stream.write(packed_t(gene_idx));
+        }
+    }
+    
+    fitness_kernel(
+        chromosome_stream,
+        result_stream,
+        record_stream,
+        vectors_in,
+        vectors_wide,
+        best_chromo.data(),
+        chromo_len,
+        dim,
+        num_bats,
+        MODE_INCREMENTAL,   // mode = 2 (incremental flip list)
+        OBJ_SUM_SQUARES,
+        false,
+        0.0f,
+        0,
+        0,
+        0,
+        0,
+        0,
+        0,
+        false,
+        &memo_lookups,
+        &memo_hits
+    );
+    
+    int incremental_received = 0;
+    errors += verify_results(result_stream, vectors_vec, chromosome_data,
+                             chromo_len, dim, incremental_received,
+                             max_abs_error, max_rel_error);
+    if (incremental_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " incremental results, got "
+                  << incremental_received << "\n";
+        errors++;
+    }
+    
+    // Indices outside the chromosome are skipped, and bats from MAX_BATS on
+    // have no resident state; every flip list is still consumed
+    for (int bat = 0; bat <= MAX_BATS; bat++) {
+        chromosome_stream.write(packed_t(2));
+        chromosome_stream.write(packed_t(chromo_len));
+        chromosome_stream.write(packed_t(-1));
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, MAX_BATS + 1, MODE_INCREMENTAL, OBJ_SUM_SQUARES, false,
+                   0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int guarded_mismatches = 0;
+    for (int bat = 0; bat < MAX_BATS; bat++) {
+        float hw_result = result_stream.read();
+        if (bat >= num_bats) continue;
+        std::vector<packed_t> batch_chromosome(chromosome_data.begin() + bat * num_chunks,
+                                               chromosome_data.begin() + (bat + 1) * num_chunks);
+        float cpu_result = cpu_reference_double(vectors_vec, batch_chromosome, chromo_len, dim);
+        float diff, rel_error;
+        bool match = compare_floats(hw_result, cpu_result, diff, rel_error);
+        if (exact_mode) match = hw_result == cpu_result;
+        if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) guarded_mismatches++;
+    }
+    float beyond_fitness = result_stream.read();
+    std::cout << "  Out-of-range indices: " << guarded_mismatches << " bats changed, bat " << MAX_BATS
+              << " reports " << beyond_fitness;
+    if (guarded_mismatches > 0) {
+        std::cout << " [ERROR: an out-of-range index was applied]\n";
+        errors++;
+    } else if (beyond_fitness != PRUNED_FITNESS || !result_stream.empty() || !chromosome_stream.empty()) {
+        std::cout << " [ERROR: expected PRUNED_FITNESS and drained streams]\n";
+        errors++;
+    } else {
+        std::cout << " [OK]\n";
+    }
+    
+    // ==== TEST 4: WIDE LOAD ====
+    std::cout << "\n[TEST 4] Reloading a new instance through the wide port (mode=3)...\n";
+    
+    // Fresh vectors so a stale cache cannot pass
+    for (int i = 0; i < chromo_len * dim; i++) {
+        vectors_in[i] = exact_mode ? static_cast<float>(rand() % 21 - 10)
+                                   : random_float(-10.0f, 10.0f);
+    }
+    for (int beat = 0; beat < num_beats; beat++) {
+        wide_t word = 0;
+        for (int k = 0; k < WIDE_FLOATS; k++) {
+            int i = beat * WIDE_FLOATS + k;
+            union { float f; unsigned int u; } bits;
+            bits.f = (i < chromo_len * dim) ? vectors_in[i] : 0.0f;
+            word.range(32 * k + 31, 32 * k) = bits.u;
+        }
+        vectors_wide[beat] = word;
+    }
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_LOAD_WIDE, OBJ_SUM_SQUARES, false, 0.0f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    if (result_stream.empty()) {
+        std::cout << "  ERROR: No completion signal received!\n";
+        errors++;
+    } else {
+        result_stream.read();
+    }
+    
+    for (size_t i = 0; i < chromosome_data.size(); i++) {
+        chromosome_stream.write(chromosome_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, OBJ_SUM_SQUARES, false, 0.0f, 0,
+                   0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    std::vector<float> wide_vectors_vec(vectors_in, vectors_in + chromo_len * dim);
+    int wide_received = 0;
+    errors += verify_results(result_stream, wide_vectors_vec, chromosome_data,
+                             chromo_len, dim, wide_received,
+                             max_abs_error, max_rel_error);
+    if (wide_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " results after wide load, got "
+                  << wide_received << "\n";
+        errors++;
+    }
+    
+    // ==== TEST 5: OUT-OF-CORE STREAMING ====
+    std::cout << "\n[TEST 5] Streaming an instance larger than MAX_GENES (mode=4)...\n";
+    
+    const int ooc_chromo_len = MAX_GENES + 500;
+    const int ooc_chunks = (ooc_chromo_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<float> ooc_vectors(ooc_chromo_len * dim);
+    for (size_t i = 0; i < ooc_vectors.size(); i++) {
+        ooc_vectors[i] = exact_mode ? static_cast<float>(rand() % 21 - 10)
+                                    : random_float(-10.0f, 10.0f);
+    }
+    std::vector<packed_t> ooc_chromosomes;
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < ooc_chunks; i++) {
+            packed_t chunk = generate_random_chunk(i, ooc_chromo_len);
+            ooc_chromosomes.push_back(chunk);
+            chromosome_stream.write(chunk);
+        }
+    }
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, ooc_vectors.data(), vectors_wide,
+                   best_chromo.data(), ooc_chromo_len, dim, num_bats, MODE_STREAM, OBJ_SUM_SQUARES, false, 0.0f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int ooc_received = 0;
+    errors += verify_results(result_stream, ooc_vectors, ooc_chromosomes,
+                             ooc_chromo_len, dim, ooc_received,
+                             max_abs_error, max_rel_error);
+    if (ooc_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " out-of-core results, got "
+                  << ooc_received << "\n";
+        errors++;
+    }
+    
+    // Bats from MAX_BATS on, and instances past OOC_MAX_GENES, do not fit
+    // on-chip: their chromosomes are still read and they report PRUNED_FITNESS
+    std::vector<float> ooc_reference(num_bats);
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> chromosome(ooc_chromosomes.begin() + bat * ooc_chunks,
+                                         ooc_chromosomes.begin() + (bat + 1) * ooc_chunks);
+        ooc_reference[bat] = cpu_reference_double(ooc_vectors, chromosome, ooc_chromo_len, dim);
+    }
+    for (int bat = 0; bat <= MAX_BATS; bat++) {
+        for (int i = 0; i < ooc_chunks; i++) {
+            chromosome_stream.write(ooc_chromosomes[(bat % num_bats) * ooc_chunks + i]);
+        }
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, ooc_vectors.data(), vectors_wide,
+                   best_chromo.data(), ooc_chromo_len, dim, MAX_BATS + 1, MODE_STREAM, OBJ_SUM_SQUARES, false,
+                   0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    int ooc_mismatches = 0;
+    for (int bat = 0; bat < MAX_BATS; bat++) {
         float hw_result = result_stream.read();
+        float diff, rel_error;
+        bool match = compare_floats(hw_result, ooc_reference[bat % num_bats], diff, rel_error);
+        if (exact_mode) match = hw_result == ooc_reference[bat % num_bats];
+        if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) ooc_mismatches++;
+    }
+    float ooc_beyond = result_stream.read();
+    
+    const int ooc_oversized_len = OOC_MAX_GENES + 1;
+    for (int i = 0; i < (ooc_oversized_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK; i++) {
+        chromosome_stream.write(generate_random_chunk(i, ooc_oversized_len));
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, ooc_vectors.data(), vectors_wide,
+                   best_chromo.data(), ooc_oversized_len, dim, 1, MODE_STREAM, OBJ_SUM_SQUARES, false, 0.0f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    float ooc_oversized = result_stream.read();
+    
+    std::cout << "  " << MAX_BATS << " bats: " << ooc_mismatches << " mismatches, bat " << MAX_BATS
+              << " reports " << ooc_beyond << ", a " << ooc_oversized_len << "-gene bat reports "
+              << ooc_oversized;
+    if (ooc_mismatches > 0) {
+        std::cout << " [ERROR: resident bats mis-evaluated]\n";
+        errors++;
+    } else if (ooc_beyond != PRUNED_FITNESS || ooc_oversized != PRUNED_FITNESS ||
+               !result_stream.empty() || !chromosome_stream.empty()) {
+        std::cout << " [ERROR: expected PRUNED_FITNESS and drained streams]\n";
+        errors++;
+    } else {
+        std::cout << " [OK]\n";
+    }
+    
+    // ==== TEST 6: OBJECTIVES ====
+    std::cout << "\n[TEST 6] Computing the L-infinity and L1 objectives...\n";
+    
+    const int objectives[] = { OBJ_MAX_ABS, OBJ_SUM_ABS };
+    for (int objective : objectives) {
+        for (size_t i = 0; i < chromosome_data.size(); i++) {
+            chromosome_stream.write(chromosome_data[i]);
+        }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, objective, false, 0.0f, 0,
+                       0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
         
-        // Compute CPU reference for this batch using double precision intermediate
+        int objective_received = 0;
+        errors += verify_results(result_stream, wide_vectors_vec, chromosome_data,
+                                 chromo_len, dim, objective_received,
+                                 max_abs_error, max_rel_error, objective);
+        if (objective_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results for objective "
+                      << objective << ", got " << objective_received << "\n";
+            errors++;
+        }
+    }
+    
+    // ==== TEST 7: DIFFERENCE VECTOR OUTPUT ====
+    std::cout << "\n[TEST 7] Streaming sumA - sumB and its argmax after each fitness...\n";
+    
+    for (size_t i = 0; i < chromosome_data.size(); i++) {
+        chromosome_stream.write(chromosome_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, OBJ_MAX_ABS, true, 0.0f, 0, 0,
+                   0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    for (int bat = 0; bat < num_bats; bat++) {
         std::vector<packed_t> batch_chromosome(
-            chromosome_data.begin() + (results_received * num_chunks),
-            chromosome_data.begin() + ((results_received + 1) * num_chunks)
+            chromosome_data.begin() + (bat * num_chunks),
+            chromosome_data.begin() + ((bat + 1) * num_chunks)
         );
+        std::vector<double> cpu_diff = cpu_difference_double(
+            wide_vectors_vec, batch_chromosome, chromo_len, dim);
         
-        float cpu_result = cpu_reference_double(
-            vectors_vec,
-            batch_chromosome,
-            chromo_len,
-            dim
+        if (result_stream.size() < static_cast<size_t>(dim + 2)) {
+            std::cout << "  Batch " << bat << ": [ERROR: truncated difference output]\n";
+            errors++;
+            break;
+        }
+        
+        float hw_fitness = result_stream.read();
+        int diff_errors = 0;
+        int cpu_argmax = 0;
+        for (int d = 0; d < dim; d++) {
+            float hw_diff = result_stream.read();
+            float abs_diff, rel_error;
+            bool match = compare_floats(hw_diff, static_cast<float>(cpu_diff[d]), abs_diff, rel_error);
+            if (exact_mode) match = (hw_diff == static_cast<float>(cpu_diff[d]));
+            if (!match && (exact_mode || abs_diff > 0.01f)) diff_errors++;
+            if (fabs(cpu_diff[d]) > fabs(cpu_diff[cpu_argmax])) cpu_argmax = d;
+        }
+        int hw_argmax = static_cast<int>(result_stream.read());
+        
+        std::cout << "  Batch " << bat << ": fitness " << hw_fitness
+                  << ", argmax HW " << hw_argmax << " / CPU " << cpu_argmax;
+        if (diff_errors == 0 && hw_argmax == cpu_argmax) {
+            std::cout << " [OK]\n";
+        } else {
+            std::cout << " [ERROR: " << diff_errors << " mismatched entries]\n";
+            errors++;
+        }
+    }
+    
+    // ==== TEST 8: EARLY-EXIT PRUNING ====
+    std::cout << "\n[TEST 8] Pruning hopeless bats against an L-infinity threshold...\n";
+    
+    // The first PRUNE_INTERVAL genes come in equal pairs of large vectors,
+    // the rest are small. Odd bats split every pair (partial difference 0,
+    // never prunable); even bats are random and usually hopeless at the
+    // first checkpoint. The last segment ends mid-chunk, with random padding
+    // that neither the segment counts nor a rebuild may take for genes.
+    const int prune_len = 4 * PRUNE_INTERVAL - 5;
+    const int prune_dim = 4;
+    const int prune_chunks = (prune_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    const float prune_threshold = 1.0f;
+    std::vector<float> prune_vectors(prune_len * prune_dim);
+    for (int gene = 0; gene < prune_len; gene++) {
+        for (int d = 0; d < prune_dim; d++) {
+            float val = static_cast<float>(rand() % 3 - 1);
+            if (gene < PRUNE_INTERVAL) {
+                val = (gene % 2) ? prune_vectors[(gene - 1) * prune_dim + d]
+                                 : static_cast<float>(rand() % 41 + 80) * ((rand() % 2) ? 1.0f : -1.0f);
+            }
+            prune_vectors[gene * prune_dim + d] = val;
+        }
+    }
+    std::vector<packed_t> prune_chromosomes;
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < prune_chunks; i++) {
+            packed_t chunk = generate_random_chunk(i, prune_len);
+            if ((bat % 2) && i < PRUNE_INTERVAL / BITS_PER_CHUNK) chunk = 0x55555555;
+            prune_chromosomes.push_back(chunk);
+        }
+    }
+    prune_chromosomes = with_padding(prune_chromosomes, prune_len);
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, prune_vectors.data(), vectors_wide,
+                   best_chromo.data(), prune_len, prune_dim, num_bats, MODE_LOAD, OBJ_MAX_ABS, false, 0.0f, 0,
+                   0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    result_stream.read();
+    
+    for (size_t i = 0; i < prune_chromosomes.size(); i++) {
+        chromosome_stream.write(prune_chromosomes[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), prune_len, prune_dim, num_bats, MODE_COMPUTE, OBJ_MAX_ABS, false,
+                   prune_threshold, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int pruned_bats = 0;
+    std::vector<bool> bat_pruned(num_bats, false);
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> batch_chromosome(
+            prune_chromosomes.begin() + (bat * prune_chunks),
+            prune_chromosomes.begin() + ((bat + 1) * prune_chunks)
         );
+        float cpu_result = cpu_reference_double(prune_vectors, batch_chromosome,
+                                                prune_len, prune_dim, OBJ_MAX_ABS);
+        if (result_stream.empty()) {
+            std::cout << "  Batch " << bat << ": [ERROR: missing result]\n";
+            errors++;
+            break;
+        }
+        float hw_result = result_stream.read();
         
-        // Compare results with intelligent tolerance
-        float diff, rel_error;
-        bool match = compare_floats(hw_result, cpu_result, diff, rel_error);
+        std::cout << "  Batch " << bat << ": HW " << hw_result << ", CPU " << cpu_result;
+        if (hw_result == PRUNED_FITNESS) {
+            // Pruning must never discard a bat that could meet the threshold
+            pruned_bats++;
+            bat_pruned[bat] = true;
+            if (cpu_result > prune_threshold) {
+                std::cout << " (pruned) [OK]\n";
+            } else {
+                std::cout << " [ERROR: pruned a bat within the threshold]\n";
+                errors++;
+            }
+        } else if (hw_result == cpu_result) {
+            std::cout << " [OK]\n";
+        } else {
+            std::cout << " [ERROR: Significant mismatch!]\n";
+            errors++;
+        }
+    }
+    std::cout << "  Pruned " << pruned_bats << "/" << num_bats << " bats\n";
+    if (pruned_bats == 0 || pruned_bats > (num_bats + 1) / 2) {
+        std::cout << "\nERROR: Expected only the random bats to be pruned\n";
+        errors++;
+    }
+    
+    // Pruned bats keep no difference: an empty flip list must rebuild it
+    // from the resident chromosome, not continue from TEST 7's
+    for (int bat = 0; bat < num_bats; bat++) chromosome_stream.write(packed_t(0));
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), prune_len, prune_dim, num_bats, MODE_INCREMENTAL, OBJ_MAX_ABS, false,
+                   0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int resumed_received = 0;
+    errors += verify_results(result_stream, prune_vectors, prune_chromosomes,
+                             prune_len, prune_dim, resumed_received,
+                             max_abs_error, max_rel_error, OBJ_MAX_ABS);
+    if (resumed_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " incremental results after pruning, got "
+                  << resumed_received << "\n";
+        errors++;
+    }
+    
+    // A threshold no bat can exceed must leave every result intact
+    for (size_t i = 0; i < prune_chromosomes.size(); i++) {
+        chromosome_stream.write(prune_chromosomes[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), prune_len, prune_dim, num_bats, MODE_COMPUTE, OBJ_MAX_ABS, false, 1.0e9f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int unpruned_received = 0;
+    errors += verify_results(result_stream, prune_vectors, prune_chromosomes,
+                             prune_len, prune_dim, unpruned_received,
+                             max_abs_error, max_rel_error, OBJ_MAX_ABS);
+    if (unpruned_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " results with a loose threshold, got "
+                  << unpruned_received << "\n";
+        errors++;
+    }
+    
+    // ==== TEST 9: TOP-K REDUCTION ====
+    std::cout << "\n[TEST 9] Reducing the population to its K best bats on-chip...\n";
+    
+    // Reference ranking of the pruning instance, best first, ties by bat index
+    std::vector<float> prune_fitness(num_bats);
+    std::vector<int> ranking;
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> batch_chromosome(
+            prune_chromosomes.begin() + (bat * prune_chunks),
+            prune_chromosomes.begin() + ((bat + 1) * prune_chunks)
+        );
+        prune_fitness[bat] = cpu_reference_double(prune_vectors, batch_chromosome,
+                                                  prune_len, prune_dim, OBJ_MAX_ABS);
+        size_t pos = 0;
+        while (pos < ranking.size() && prune_fitness[ranking[pos]] <= prune_fitness[bat]) pos++;
+        ranking.insert(ranking.begin() + pos, bat);
+    }
+    
+    // One slot more than there are bats, then again with pruning: the
+    // hopeless bats drop out and leave empty slots behind
+    const float topk_thresholds[] = { 0.0f, prune_threshold };
+    for (float threshold : topk_thresholds) {
+        const int top_k = num_bats + 1;
+        std::vector<int> expected;
+        for (int bat : ranking) {
+            if (threshold == 0.0f || !bat_pruned[bat]) expected.push_back(bat);
+        }
         
-        // Update max errors
-        if (diff > max_abs_error) max_abs_error = diff;
-        if (rel_error > max_rel_error) max_rel_error = rel_error;
+        for (size_t i = 0; i < prune_chromosomes.size(); i++) {
+            chromosome_stream.write(prune_chromosomes[i]);
+        }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), prune_len, prune_dim, num_bats, MODE_COMPUTE, OBJ_MAX_ABS, false,
+                       threshold, top_k, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
         
-        std::cout << "  Batch " << results_received << ":\n";
-        std::cout << "    HW result:  " << hw_result << "\n";
-        std::cout << "    CPU result: " << cpu_result << "\n";
-        std::cout << "    Difference: " << diff << "\n";
-        std::cout << "    Rel error:  " << (rel_error * 100) << "%\n";
+        if (result_stream.size() != static_cast<size_t>(2 * top_k)) {
+            std::cout << "  [ERROR: expected " << 2 * top_k << " values, got "
+                      << result_stream.size() << "]\n";
+            errors++;
+            while (!result_stream.empty()) result_stream.read();
+            continue;
+        }
         
-        // Analyze the error pattern
-        if (diff > 0) {
-            // Check if error is a power of 2 (common in floating-point rounding)
-            float log2_diff = log2f(diff);
-            float rounded_log2 = roundf(log2_diff);
-            if (fabs(log2_diff - rounded_log2) < 0.1f) {
-                std::cout << "    Error type: Power of 2 rounding (2^" << rounded_log2 << ")\n";
+        for (int slot = 0; slot < top_k; slot++) {
+            float hw_fitness = result_stream.read();
+            int hw_bat = static_cast<int>(result_stream.read());
+            int cpu_bat = slot < static_cast<int>(expected.size()) ? expected[slot] : -1;
+            float cpu_fitness = cpu_bat < 0 ? PRUNED_FITNESS : prune_fitness[cpu_bat];
+            
+            std::cout << "  Threshold " << threshold << ", slot " << slot << ": HW bat " << hw_bat
+                      << " (" << hw_fitness << "), CPU bat " << cpu_bat << " (" << cpu_fitness << ")";
+            if (hw_bat == cpu_bat && hw_fitness == cpu_fitness) {
+                std::cout << " [OK]\n";
+            } else {
+                std::cout << " [ERROR: ranking mismatch]\n";
+                errors++;
+            }
+        }
+    }
+    
+    // ==== TEST 10: NAMED VARIANTS ====
+    std::cout << "\n[TEST 10] Instances beyond fitness_kernel's shape on the named variants...\n";
+    
+    typedef void (*fitness_top_fn)(hls::stream<packed_t>&, hls::stream<float>&, hls::stream<result_beat_t>&,
+                                   const float*, const wide_t*, packed_t*, int, int, int, int, int, bool,
+                                   float, int, int, unsigned int, int, int, int, bool, unsigned int*,
+                                   unsigned int*);
+    struct variant_case {
+        const char* name;
+        fitness_top_fn top;
+        int chromo_len;
+        int dim;
+    };
+    // Each shape exceeds either MAX_GENES or MAX_DIM
+    const variant_case variants[] = {
+        { "fitness_top", fitness_top, 3 * MAX_GENES, SMALL_DIM_MAX_DIM },
+        { "fitness_top_large_dim", fitness_top_large_dim, LARGE_DIM_MAX_GENES, 2 * MAX_DIM },
+    };
+    for (const variant_case& variant : variants) {
+        const int variant_chunks = (variant.chromo_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+        std::vector<float> variant_vectors(variant.chromo_len * variant.dim);
+        for (size_t i = 0; i < variant_vectors.size(); i++) {
+            variant_vectors[i] = exact_mode ? static_cast<float>(rand() % 21 - 10)
+                                            : random_float(-10.0f, 10.0f);
+        }
+        std::vector<packed_t> variant_chromosomes;
+        for (int bat = 0; bat < num_bats; bat++) {
+            for (int i = 0; i < variant_chunks; i++) {
+                variant_chromosomes.push_back(generate_random_chunk(i, variant.chromo_len));
             }
         }
         
-        if (!match) {
-            std::cout << "    [WARNING: Small numerical difference]\n";
-            // Only count as error if it's significant
-            if (diff > 0.1f || rel_error > 0.001f) {  // 0.1 absolute or 0.1% relative
-                std::cout << "    [ERROR: Significant mismatch!]\n";
+        std::cout << "  " << variant.name << ": " << variant.chromo_len << " genes x "
+                  << variant.dim << " dims\n";
+        variant.top(chromosome_stream, result_stream, record_stream, variant_vectors.data(), vectors_wide,
+                    best_chromo.data(), variant.chromo_len, variant.dim, num_bats, MODE_LOAD, OBJ_SUM_SQUARES,
+                    false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        result_stream.read();
+        
+        for (size_t i = 0; i < variant_chromosomes.size(); i++) {
+            chromosome_stream.write(variant_chromosomes[i]);
+        }
+        variant.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                    best_chromo.data(), variant.chromo_len, variant.dim, num_bats, MODE_COMPUTE,
+                    OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        
+        int variant_received = 0;
+        errors += verify_results(result_stream, variant_vectors, variant_chromosomes,
+                                 variant.chromo_len, variant.dim, variant_received,
+                                 max_abs_error, max_rel_error);
+        if (variant_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results from " << variant.name
+                      << ", got " << variant_received << "\n";
+            errors++;
+        }
+        
+        // Flip the first and last gene of every bat: both ends of the cache rows
+        const int edge_genes[2] = { 0, variant.chromo_len - 1 };
+        for (int bat = 0; bat < num_bats; bat++) {
+            chromosome_stream.write(packed_t(2));
+            for (int f = 0; f < 2; f++) {
+                packed_t& chunk = variant_chromosomes[bat * variant_chunks + edge_genes[f] / BITS_PER_CHUNK];
+                int bit = edge_genes[f] % BITS_PER_CHUNK;
+                chunk.set_bit(bit, !chunk[bit]);
+                chromosome_stream.write(packed_t(edge_genes[f]));
+            }
+        }
+        variant.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                    best_chromo.data(), variant.chromo_len, variant.dim, num_bats, MODE_INCREMENTAL,
+                    OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        
+        variant_received = 0;
+        errors += verify_results(result_stream, variant_vectors, variant_chromosomes,
+                                 variant.chromo_len, variant.dim, variant_received,
+                                 max_abs_error, max_rel_error);
+        if (variant_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " incremental results from " << variant.name
+                      << ", got " << variant_received << "\n";
+            errors++;
+        }
+        
+        // Reload through the 512-bit port: beats that straddle genes
+        std::vector<wide_t> variant_wide((variant_vectors.size() + WIDE_FLOATS - 1) / WIDE_FLOATS);
+        for (size_t beat = 0; beat < variant_wide.size(); beat++) {
+            wide_t word = 0;
+            for (int k = 0; k < WIDE_FLOATS; k++) {
+                size_t i = beat * WIDE_FLOATS + k;
+                union { float f; unsigned int u; } bits;
+                bits.f = (i < variant_vectors.size()) ? variant_vectors[i] : 0.0f;
+                word.range(32 * k + 31, 32 * k) = bits.u;
+            }
+            variant_wide[beat] = word;
+        }
+        variant.top(chromosome_stream, result_stream, record_stream, vectors_in, variant_wide.data(),
+                    best_chromo.data(), variant.chromo_len, variant.dim, num_bats, MODE_LOAD_WIDE,
+                    OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        result_stream.read();
+        
+        for (size_t i = 0; i < variant_chromosomes.size(); i++) {
+            chromosome_stream.write(variant_chromosomes[i]);
+        }
+        variant.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                    best_chromo.data(), variant.chromo_len, variant.dim, num_bats, MODE_COMPUTE,
+                    OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        
+        variant_received = 0;
+        errors += verify_results(result_stream, variant_vectors, variant_chromosomes,
+                                 variant.chromo_len, variant.dim, variant_received,
+                                 max_abs_error, max_rel_error);
+        if (variant_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results from " << variant.name
+                      << " after a wide load, got " << variant_received << "\n";
+            errors++;
+        }
+    }
+    
+    // ==== TEST 11: ON-CHIP BAT ALGORITHM ====
+    std::cout << "\n[TEST 11] Running the binary bat algorithm on-chip (mode=5)...\n";
+    
+    const int engine_bats = 8;
+    const int engine_generations = 40;
+    const unsigned int engine_seed = 12345;
+    std::vector<packed_t> engine_population;
+    float initial_best = std::numeric_limits<float>::max();
+    for (int bat = 0; bat < engine_bats; bat++) {
+        std::vector<packed_t> chromosome;
+        for (int i = 0; i < num_chunks; i++) chromosome.push_back(generate_random_chunk(i, chromo_len));
+        initial_best = fmin(initial_best, cpu_reference_double(wide_vectors_vec, chromosome,
+                                                               chromo_len, dim, OBJ_MAX_ABS));
+        engine_population.insert(engine_population.end(), chromosome.begin(), chromosome.end());
+    }
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_LOAD, OBJ_SUM_SQUARES, false, 0.0f, 0, 0,
+                   0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    result_stream.read();
+    
+    // Same seed twice: the run must be reproducible
+    std::vector<packed_t> engine_best[2];
+    float engine_fitness[2] = { 0.0f, 0.0f };
+    for (int run = 0; run < 2; run++) {
+        for (size_t i = 0; i < engine_population.size(); i++) {
+            chromosome_stream.write(engine_population[i]);
+        }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), chromo_len, dim, engine_bats, MODE_BAT, OBJ_MAX_ABS, false, 0.0f, 0,
+                       engine_generations, engine_seed, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        
+        if (result_stream.size() != 1 || !chromosome_stream.empty()) {
+            std::cout << "  [ERROR: expected a single fitness and a drained chromosome stream]\n";
+            errors++;
+            while (!result_stream.empty()) result_stream.read();
+            break;
+        }
+        engine_fitness[run] = result_stream.read();
+        engine_best[run].assign(best_chromo.begin(), best_chromo.begin() + num_chunks);
+    }
+    
+    float cpu_engine = cpu_reference_double(wide_vectors_vec, engine_best[0], chromo_len, dim, OBJ_MAX_ABS);
+    float engine_diff, engine_rel;
+    bool engine_match = compare_floats(engine_fitness[0], cpu_engine, engine_diff, engine_rel);
+    if (exact_mode) engine_match = (engine_fitness[0] == cpu_engine);
+    
+    std::cout << "  Best initial fitness: " << initial_best << "\n";
+    std::cout << "  After " << engine_generations << " generations: HW " << engine_fitness[0]
+              << ", CPU on returned chromosome " << cpu_engine;
+    if (!engine_match && (exact_mode || engine_diff > 0.1f || engine_rel > 0.001f)) {
+        std::cout << " [ERROR: fitness does not match the returned chromosome]\n";
+        errors++;
+    } else if (engine_fitness[0] > initial_best) {
+        std::cout << " [ERROR: worse than the initial population]\n";
+        errors++;
+    } else if (engine_fitness[1] != engine_fitness[0] || engine_best[1] != engine_best[0]) {
+        std::cout << " [ERROR: not reproducible with the same seed]\n";
+        errors++;
+    } else {
+        std::cout << " [OK]\n";
+    }
+    
+    // A population beyond ENGINE_MAX_BATS: the surplus is read and dropped
+    const int surplus_bats = ENGINE_MAX_BATS + 2;
+    for (int bat = 0; bat < surplus_bats; bat++) {
+        for (int i = 0; i < num_chunks; i++) {
+            chromosome_stream.write(engine_population[(bat % engine_bats) * num_chunks + i]);
+        }
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, surplus_bats, MODE_BAT, OBJ_MAX_ABS, false, 0.0f, 0,
+                   2, engine_seed, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    std::cout << "  " << surplus_bats << " bats sent: " << chromosome_stream.size() << " words left, "
+              << result_stream.size() << " result(s)";
+    if (!chromosome_stream.empty() || result_stream.size() != 1) {
+        std::cout << " [ERROR: expected a single fitness and a drained chromosome stream]\n";
+        errors++;
+        while (!chromosome_stream.empty()) chromosome_stream.read();
+    } else {
+        std::cout << " [OK]\n";
+    }
+    while (!result_stream.empty()) result_stream.read();
+    
+    // No population: a defined result, PRUNED_FITNESS and a zero chromosome
+    for (size_t i = 0; i < best_chromo.size(); i++) best_chromo[i] = packed_t(0xFFFFFFFF);
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, 0, MODE_BAT, OBJ_MAX_ABS, false, 0.0f, 0, 2,
+                   engine_seed, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    bool empty_best_zero = true;
+    for (int i = 0; i < num_chunks; i++) {
+        if (best_chromo[i] != 0) empty_best_zero = false;
+    }
+    const float empty_fitness = result_stream.empty() ? 0.0f : result_stream.read();
+    std::cout << "  0 bats: fitness " << empty_fitness;
+    if (empty_fitness != PRUNED_FITNESS || !empty_best_zero || !result_stream.empty()) {
+        std::cout << " [ERROR: expected a single PRUNED_FITNESS and a zero best chromosome]\n";
+        errors++;
+        while (!result_stream.empty()) result_stream.read();
+    } else {
+        std::cout << " [OK]\n";
+    }
+    
+    // ==== TEST 12: RNG BANK ====
+    std::cout << "\n[TEST 12] Random restarts and random walks from the on-chip RNG bank...\n";
+    
+    // Random restarts: the returned chromosome must be the best one evaluated,
+    // with clean padding, and a reseed must replay the same population
+    std::vector<float> restart_fitness[2];
+    for (int run = 0; run < 2; run++) {
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), chromo_len, dim, num_bats, MODE_RANDOM, OBJ_MAX_ABS, false, 0.0f, 0,
+                       0, 777, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        while (!result_stream.empty()) restart_fitness[run].push_back(result_stream.read());
+    }
+    
+    if (restart_fitness[0].size() != static_cast<size_t>(num_bats)) {
+        std::cout << "  [ERROR: expected " << num_bats << " restart results, got "
+                  << restart_fitness[0].size() << "]\n";
+        errors++;
+    } else {
+        float restart_best = restart_fitness[0][0];
+        for (float fitness : restart_fitness[0]) restart_best = fmin(restart_best, fitness);
+        std::vector<packed_t> restart_chromo(best_chromo.begin(), best_chromo.begin() + num_chunks);
+        float cpu_restart = cpu_reference_double(wide_vectors_vec, restart_chromo, chromo_len, dim, OBJ_MAX_ABS);
+        bool padding_clear = (restart_chromo[num_chunks - 1] >> (chromo_len - (num_chunks - 1) * BITS_PER_CHUNK)) == 0;
+        float restart_diff, restart_rel;
+        bool restart_match = compare_floats(restart_best, cpu_restart, restart_diff, restart_rel);
+        if (exact_mode) restart_match = (restart_best == cpu_restart);
+        
+        std::cout << "  Restarts: best HW " << restart_best << ", CPU on returned chromosome " << cpu_restart;
+        if (!restart_match && (exact_mode || restart_diff > 0.1f || restart_rel > 0.001f)) {
+            std::cout << " [ERROR: returned chromosome is not the best restart]\n";
+            errors++;
+        } else if (!padding_clear) {
+            std::cout << " [ERROR: padding bits set]\n";
+            errors++;
+        } else if (restart_fitness[1] != restart_fitness[0]) {
+            std::cout << " [ERROR: reseeding did not replay the restarts]\n";
+            errors++;
+        } else {
+            std::cout << " [OK]\n";
+        }
+    }
+    
+    // Random walk from the resident TEST 2 population: the best walker may
+    // differ from its start in at most walk_flips genes
+    const int walk_flips = 3;
+    for (size_t i = 0; i < chromosome_data.size(); i++) {
+        chromosome_stream.write(chromosome_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, OBJ_MAX_ABS, false, 0.0f, 0, 0,
+                   0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    while (!result_stream.empty()) result_stream.read();
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_WALK, OBJ_MAX_ABS, false, 0.0f, 0, 0, 99,
+                   walk_flips, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    std::vector<float> walk_fitness;
+    while (!result_stream.empty()) walk_fitness.push_back(result_stream.read());
+    if (walk_fitness.size() != static_cast<size_t>(num_bats)) {
+        std::cout << "  [ERROR: expected " << num_bats << " walk results, got " << walk_fitness.size() << "]\n";
+        errors++;
+    } else {
+        int walk_best = 0;
+        for (int bat = 1; bat < num_bats; bat++) {
+            if (walk_fitness[bat] < walk_fitness[walk_best]) walk_best = bat;
+        }
+        std::vector<packed_t> walk_chromo(best_chromo.begin(), best_chromo.begin() + num_chunks);
+        float cpu_walk = cpu_reference_double(wide_vectors_vec, walk_chromo, chromo_len, dim, OBJ_MAX_ABS);
+        int distance = 0;
+        for (int i = 0; i < num_chunks; i++) {
+            packed_t moved = walk_chromo[i] ^ chromosome_data[walk_best * num_chunks + i];
+            for (int bit = 0; bit < BITS_PER_CHUNK; bit++) distance += moved[bit] ? 1 : 0;
+        }
+        float walk_diff, walk_rel;
+        bool walk_match = compare_floats(walk_fitness[walk_best], cpu_walk, walk_diff, walk_rel);
+        if (exact_mode) walk_match = (walk_fitness[walk_best] == cpu_walk);
+        
+        std::cout << "  Walk: best bat " << walk_best << " HW " << walk_fitness[walk_best]
+                  << ", CPU " << cpu_walk << ", " << distance << " genes from its start";
+        if (!walk_match && (exact_mode || walk_diff > 0.1f || walk_rel > 0.001f)) {
+            std::cout << " [ERROR: fitness does not match the returned chromosome]\n";
+            errors++;
+        } else if (distance > walk_flips || distance % 2 != walk_flips % 2) {
+            std::cout << " [ERROR: walked further than " << walk_flips << " flips]\n";
+            errors++;
+        } else {
+            std::cout << " [OK]\n";
+        }
+    }
+    
+    // ==== TEST 13: PING-PONG CACHE ====
+    std::cout << "\n[TEST 13] Preloading the shadow bank during compute, then swapping (mode=8)...\n";
+    
+    // Instance A is the resident one of the earlier tests, loaded into the
+    // ping-pong variant. Instance B, a different shape, goes in through
+    // vectors_wide while A is evaluated
+    std::vector<float> pingpong_stored;
+    std::vector<wide_t> pingpong_wide = pack_halves<bf16_t>(wide_vectors_vec, pingpong_stored);
+    fitness_top_uram(chromosome_stream, result_stream, record_stream, vectors_in, pingpong_wide.data(),
+                     best_chromo.data(), chromo_len, dim, num_bats, MODE_LOAD_WIDE, OBJ_SUM_SQUARES, false,
+                     0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    result_stream.read();
+    
+    const int preload_len = chromo_len / 2 + 3;
+    const int preload_dim = dim > 1 ? dim - 1 : 1;
+    const int preload_chunks = (preload_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<float> preload_vectors(preload_len * preload_dim);
+    for (size_t i = 0; i < preload_vectors.size(); i++) {
+        preload_vectors[i] = exact_mode ? static_cast<float>(rand() % 21 - 10)
+                                        : random_float(-10.0f, 10.0f);
+    }
+    std::vector<float> preload_stored;
+    std::vector<wide_t> preload_wide = pack_halves<bf16_t>(preload_vectors, preload_stored);
+    std::vector<packed_t> preload_chromosomes;
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < preload_chunks; i++) {
+            preload_chromosomes.push_back(generate_random_chunk(i, preload_len));
+        }
+    }
+    
+    // A with B preloading, B after the swap, A again after swapping back, and
+    // A still after an empty load, which must not swap in the stale shadow
+    const char* pingpong_phase[4] = { "active bank during preload", "swapped-in bank", "swapped-back bank",
+                                      "active bank after an empty load" };
+    for (int phase = 0; phase < 4; phase++) {
+        if (phase > 0) {
+            const bool empty_load = phase == 3;
+            fitness_top_uram(chromosome_stream, result_stream, record_stream, vectors_in, preload_wide.data(),
+                             best_chromo.data(), empty_load ? 0 : chromo_len, dim, num_bats,
+                             empty_load ? MODE_LOAD_WIDE : MODE_SWAP, OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0,
+                             0, 0, false, &memo_lookups, &memo_hits);
+            if (result_stream.size() != 1) {
+                std::cout << "  ERROR: No completion signal received for the "
+                          << (empty_load ? "empty load" : "swap") << "!\n";
+                errors++;
+            }
+            while (!result_stream.empty()) result_stream.read();
+        }
+        
+        const bool on_b = phase == 1;
+        const std::vector<packed_t>& phase_chromosomes = on_b ? preload_chromosomes : chromosome_data;
+        for (size_t i = 0; i < phase_chromosomes.size(); i++) {
+            chromosome_stream.write(phase_chromosomes[i]);
+        }
+        fitness_top_uram(chromosome_stream, result_stream, record_stream, vectors_in, preload_wide.data(),
+                         best_chromo.data(), on_b ? preload_len : chromo_len, on_b ? preload_dim : dim, num_bats,
+                         MODE_COMPUTE, OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, phase == 0 ? preload_len : 0,
+                         phase == 0 ? preload_dim : 0, false, &memo_lookups, &memo_hits);
+        
+        std::cout << "  " << pingpong_phase[phase] << ":\n";
+        int pingpong_received = 0;
+        errors += verify_results(result_stream, on_b ? preload_stored : pingpong_stored, phase_chromosomes,
+                                 on_b ? preload_len : chromo_len, on_b ? preload_dim : dim, pingpong_received,
+                                 max_abs_error, max_rel_error);
+        if (pingpong_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results from the " << pingpong_phase[phase]
+                      << ", got " << pingpong_received << "\n";
+            errors++;
+        }
+    }
+    
+    // fitness_kernel has a single bank: the preload is ignored and the swap
+    // only acknowledges, so A stays resident
+    std::vector<wide_t> preload_float_wide((preload_vectors.size() + WIDE_FLOATS - 1) / WIDE_FLOATS);
+    for (size_t beat = 0; beat < preload_float_wide.size(); beat++) {
+        wide_t word = 0;
+        for (int k = 0; k < WIDE_FLOATS; k++) {
+            size_t i = beat * WIDE_FLOATS + k;
+            union { float f; unsigned int u; } bits;
+            bits.f = (i < preload_vectors.size()) ? preload_vectors[i] : 0.0f;
+            word.range(32 * k + 31, 32 * k) = bits.u;
+        }
+        preload_float_wide[beat] = word;
+    }
+    for (int call = 0; call < 3; call++) {
+        const bool swap = call == 1;
+        if (!swap) {
+            for (size_t i = 0; i < chromosome_data.size(); i++) {
+                chromosome_stream.write(chromosome_data[i]);
+            }
+        }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, preload_float_wide.data(),
+                       best_chromo.data(), chromo_len, dim, num_bats, swap ? MODE_SWAP : MODE_COMPUTE,
+                       OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, call == 0 ? preload_len : 0,
+                       call == 0 ? preload_dim : 0, false, &memo_lookups, &memo_hits);
+        if (swap) {
+            if (result_stream.size() != 1) {
+                std::cout << "  ERROR: No completion signal received for fitness_kernel's swap!\n";
                 errors++;
             }
+            while (!result_stream.empty()) result_stream.read();
+            continue;
+        }
+        
+        std::cout << "  fitness_kernel " << (call == 0 ? "with a preload" : "after MODE_SWAP") << ":\n";
+        int single_received = 0;
+        errors += verify_results(result_stream, wide_vectors_vec, chromosome_data, chromo_len, dim,
+                                 single_received, max_abs_error, max_rel_error);
+        if (single_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results from fitness_kernel, got "
+                      << single_received << "\n";
+            errors++;
+        }
+    }
+    
+    // ==== TEST 14: COMMAND-STREAM SERVER ====
+    std::cout << "\n[TEST 14] Driving fitness_server through command packets...\n";
+    
+    hls::stream<packed_t> command_stream;
+    // Session 1: load, then evaluate under OBJ_MAX_ABS. Session 2 runs after
+    // the kernel restarts and must still find the instance resident.
+    for (int session = 0; session < 2; session++) {
+        const int session_objective = session == 0 ? OBJ_MAX_ABS : OBJ_SUM_SQUARES;
+        command_stream.write(packed_t(CMD_SET_SHAPE));
+        command_stream.write(packed_t(chromo_len));
+        command_stream.write(packed_t(dim));
+        if (session == 0) {
+            command_stream.write(packed_t(CMD_RUN));
+            command_stream.write(packed_t(MODE_LOAD));
+            command_stream.write(packed_t(0));
+        }
+        command_stream.write(packed_t(CMD_SET_OBJECTIVE));
+        command_stream.write(packed_t(session_objective));
+        command_stream.write(packed_t(0));
+        command_stream.write(packed_t(CMD_RUN));
+        command_stream.write(packed_t(MODE_COMPUTE));
+        command_stream.write(packed_t(num_bats));
+        command_stream.write(packed_t(CMD_HALT));
+        for (size_t i = 0; i < chromosome_data.size(); i++) {
+            chromosome_stream.write(chromosome_data[i]);
+        }
+        
+        fitness_server(command_stream, chromosome_stream, result_stream, record_stream, vectors_in,
+                       vectors_wide, best_chromo.data());
+        
+        if (!command_stream.empty() || !chromosome_stream.empty()) {
+            std::cout << "  ERROR: Session " << session << " left commands or chromosomes unread!\n";
+            errors++;
+        }
+        if (session == 0) {
+            if (result_stream.empty()) {
+                std::cout << "  ERROR: No completion signal received for the load command!\n";
+                errors++;
+            } else {
+                result_stream.read();
+            }
+        }
+        
+        std::cout << "  Session " << session << ":\n";
+        int server_received = 0;
+        errors += verify_results(result_stream, wide_vectors_vec, chromosome_data,
+                                 chromo_len, dim, server_received,
+                                 max_abs_error, max_rel_error, session_objective);
+        if (server_received != num_bats) {
+            std::cout << "\nERROR: Expected " << num_bats << " results from session " << session
+                      << ", got " << server_received << "\n";
+            errors++;
+        }
+    }
+    
+    // ==== TEST 15: WIDE CHROMOSOME BEATS ====
+    std::cout << "\n[TEST 15] Feeding fitness_kernel_wide_in " << CHROMO_BEAT_CHUNKS << " chunks per beat...\n";
+    
+    hls::stream<chromo_beat_t> chromosome_beats;
+    fitness_kernel_wide_in(chromosome_beats, result_stream, record_stream, vectors_in, vectors_wide,
+                           best_chromo.data(), chromo_len, dim, num_bats, MODE_LOAD, OBJ_SUM_SQUARES, false,
+                           0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    while (!result_stream.empty()) result_stream.read();
+    
+    // Whole chromosomes, each starting on a fresh beat
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < num_chunks; i += CHROMO_BEAT_CHUNKS) {
+            chromo_beat_t beat = 0;
+            for (int slot = 0; slot < CHROMO_BEAT_CHUNKS && i + slot < num_chunks; slot++) {
+                beat.range(32 * slot + 31, 32 * slot) = chromosome_data[bat * num_chunks + i + slot];
+            }
+            chromosome_beats.write(beat);
+        }
+    }
+    fitness_kernel_wide_in(chromosome_beats, result_stream, record_stream, vectors_in, vectors_wide,
+                           best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, OBJ_SUM_SQUARES, false,
+                           0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int beats_received = 0;
+    errors += verify_results(result_stream, wide_vectors_vec, chromosome_data,
+                             chromo_len, dim, beats_received,
+                             max_abs_error, max_rel_error);
+    
+    // Flip lists long enough to span several beats
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> record(1, packed_t(CHROMO_BEAT_CHUNKS + bat));
+        for (int f = 0; f < CHROMO_BEAT_CHUNKS + bat; f++) {
+            int gene_idx = rand() % chromo_len;
+            packed_t& chunk = chromosome_data[bat * num_chunks + gene_idx / BITS_PER_CHUNK];
+            int bit = gene_idx % BITS_PER_CHUNK;
+            chunk.set_bit(bit, !chunk[bit]);
+            record.push_back(packed_t(gene_idx));
+        }
+        for (size_t i = 0; i < record.size(); i += CHROMO_BEAT_CHUNKS) {
+            chromo_beat_t beat = 0;
+            for (size_t slot = 0; slot < CHROMO_BEAT_CHUNKS && i + slot < record.size(); slot++) {
+                beat.range(32 * slot + 31, 32 * slot) = record[i + slot];
+            }
+            chromosome_beats.write(beat);
+        }
+    }
+    fitness_kernel_wide_in(chromosome_beats, result_stream, record_stream, vectors_in, vectors_wide,
+                           best_chromo.data(), chromo_len, dim, num_bats, MODE_INCREMENTAL, OBJ_SUM_SQUARES,
+                           false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int beat_flips_received = 0;
+    errors += verify_results(result_stream, wide_vectors_vec, chromosome_data,
+                             chromo_len, dim, beat_flips_received,
+                             max_abs_error, max_rel_error);
+    if (beats_received != num_bats || beat_flips_received != num_bats || !chromosome_beats.empty()) {
+        std::cout << "\nERROR: Expected " << num_bats << " results per call and a drained beat stream, got "
+                  << beats_received << " and " << beat_flips_received << "\n";
+        errors++;
+    }
+    
+    // An unknown mode forwards no beats and must not wait for any
+    const int unknown_mode = 99;
+    fitness_kernel_wide_in(chromosome_beats, result_stream, record_stream, vectors_in, vectors_wide,
+                           best_chromo.data(), chromo_len, dim, num_bats, unknown_mode, OBJ_SUM_SQUARES, false,
+                           0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    std::cout << "  Mode " << unknown_mode << ": " << result_stream.size() << " results";
+    if (result_stream.empty() && record_stream.empty()) {
+        std::cout << " [OK]\n";
+    } else {
+        std::cout << " [ERROR: an unknown mode produced output]\n";
+        errors++;
+        while (!result_stream.empty()) result_stream.read();
+        while (!record_stream.empty()) record_stream.read();
+    }
+    
+    // ==== TEST 16: PACKED RESULT RECORDS ====
+    std::cout << "\n[TEST 16] Packing (fitness, bat, popcount) records " << RESULT_RECORDS << " per beat...\n";
+    
+    // Full evaluation, flips on every bat (popcounts must follow), top-2, then
+    // out-of-core. Padding bits are set and must not be counted
+    std::vector<packed_t> record_data = with_padding(chromosome_data, chromo_len);
+    for (int pass = 0; pass < 4; pass++) {
+        int pass_mode = MODE_COMPUTE;
+        int pass_top_k = 0;
+        if (pass == 0 || pass == 3) {
+            if (pass == 3) pass_mode = MODE_STREAM;
+            for (size_t i = 0; i < record_data.size(); i++) {
+                chromosome_stream.write(record_data[i]);
+            }
+        } else if (pass == 1) {
+            pass_mode = MODE_INCREMENTAL;
+            for (int bat = 0; bat < num_bats; bat++) {
+                chromosome_stream.write(packed_t(bat + 1));
+                for (int f = 0; f <= bat; f++) {
+                    int gene_idx = rand() % chromo_len;
+                    packed_t& chunk = record_data[bat * num_chunks + gene_idx / BITS_PER_CHUNK];
+                    int bit = gene_idx % BITS_PER_CHUNK;
+                    chunk.set_bit(bit, !chunk[bit]);
+                    chromosome_stream.write(packed_t(gene_idx));
+                }
+            }
         } else {
-            std::cout << "    [OK]\n";
+            pass_mode = MODE_INCREMENTAL;
+            pass_top_k = 2;
+            for (int bat = 0; bat < num_bats; bat++) chromosome_stream.write(packed_t(0));
         }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), chromo_len, dim, num_bats, pass_mode, OBJ_SUM_SQUARES, false, 0.0f,
+                       pass_top_k, 0, 0, 0, 0, 0, true, &memo_lookups, &memo_hits);
         
-        results_received++;
+        const int expected_records = pass_top_k > 0 ? pass_top_k : num_bats;
+        const int expected_beats = (expected_records + RESULT_RECORDS - 1) / RESULT_RECORDS;
+        if (!result_stream.empty() || record_stream.size() != static_cast<size_t>(expected_beats)) {
+            std::cout << "  [ERROR: pass " << pass << " expected " << expected_beats
+                      << " record beats and no bare floats]\n";
+            errors++;
+            while (!result_stream.empty()) result_stream.read();
+            while (!record_stream.empty()) record_stream.read();
+            continue;
+        }
+        
+        float prev_fitness = -1.0f;
+        result_beat_t beat = 0;
+        for (int r = 0; r < expected_beats * RESULT_RECORDS; r++) {
+            if (r % RESULT_RECORDS == 0) beat = record_stream.read();
+            ap_uint<64> record = beat.range(64 * (r % RESULT_RECORDS) + 63, 64 * (r % RESULT_RECORDS));
+            union { unsigned int u; float f; } bits;
+            bits.u = record.range(31, 0).to_uint();
+            const int bat = record.range(47, 32).to_int();
+            const int ones = record.range(63, 48).to_int();
+            
+            if (r >= expected_records) {
+                if (bat != RESULT_NO_BAT) {
+                    std::cout << "  [ERROR: padding record " << r << " carries bat " << bat << "]\n";
+                    errors++;
+                }
+                continue;
+            }
+            if (bat >= num_bats || (pass_top_k == 0 && bat != r)) {
+                std::cout << "  [ERROR: record " << r << " carries bat " << bat << "]\n";
+                errors++;
+                continue;
+            }
+            std::vector<packed_t> chromosome(record_data.begin() + bat * num_chunks,
+                                             record_data.begin() + (bat + 1) * num_chunks);
+            int cpu_ones = 0;
+            for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
+                cpu_ones += chromosome[gene_idx / BITS_PER_CHUNK][gene_idx % BITS_PER_CHUNK] ? 1 : 0;
+            }
+            float cpu_fitness = cpu_reference_double(wide_vectors_vec, chromosome, chromo_len, dim);
+            float diff, rel_error;
+            bool match = compare_floats(bits.f, cpu_fitness, diff, rel_error);
+            if (exact_mode) match = bits.f == cpu_fitness;
+            
+            std::cout << "  Pass " << pass << " record " << r << ": bat " << bat << ", fitness HW " << bits.f
+                      << " CPU " << cpu_fitness << ", popcount " << ones << "/" << cpu_ones;
+            if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) {
+                std::cout << " [ERROR: fitness mismatch]\n";
+                errors++;
+            } else if (ones != cpu_ones) {
+                std::cout << " [ERROR: popcount mismatch]\n";
+                errors++;
+            } else if (pass_top_k > 0 && bits.f < prev_fitness) {
+                std::cout << " [ERROR: top-K records out of order]\n";
+                errors++;
+            } else {
+                std::cout << " [OK]\n";
+            }
+            prev_fitness = bits.f;
+        }
+    }
+    
+    // ==== TEST 17: 16-BIT VECTOR STORAGE ====
+    std::cout << "\n[TEST 17] Twice the genes in bf16 / fp16 storage, accumulated in acc_t...\n";
+    
+    typedef std::vector<wide_t> (*pack_fn)(const std::vector<float>&, std::vector<float>&);
+    struct storage_case {
+        const char* name;
+        fitness_top_fn top;
+        pack_fn pack;
+    };
+    const storage_case storage_cases[] = {
+        { "fitness_top_bf16", fitness_top_bf16, pack_halves<bf16_t> },
+        { "fitness_top_fp16", fitness_top_fp16, pack_halves<fp16_t> },
+    };
+    const int half_len = HALF_STORE_MAX_GENES;
+    const int half_dim = MAX_DIM;
+    const int half_chunks = (half_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<float> half_vectors(half_len * half_dim);
+    for (size_t i = 0; i < half_vectors.size(); i++) {
+        half_vectors[i] = exact_mode ? static_cast<float>(rand() % 21 - 10) : random_float(-10.0f, 10.0f);
+    }
+    std::vector<packed_t> half_chromosomes;
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < half_chunks; i++) {
+            half_chromosomes.push_back(generate_random_chunk(i, half_len));
+        }
+    }
+    
+    for (const storage_case& storage : storage_cases) {
+        std::vector<float> rounded_vectors;
+        std::vector<wide_t> half_beats = storage.pack(half_vectors, rounded_vectors);
+        float storage_rel_error = 0.0f;
+        
+        // Rounded on the fly from vectors_in, then from pre-packed 16-bit beats
+        const int load_modes[2] = { MODE_LOAD, MODE_LOAD_WIDE };
+        for (int load_mode : load_modes) {
+            storage.top(chromosome_stream, result_stream, record_stream, half_vectors.data(), half_beats.data(),
+                        best_chromo.data(), half_len, half_dim, num_bats, load_mode, OBJ_SUM_SQUARES, false,
+                        0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+            result_stream.read();
+            
+            for (size_t i = 0; i < half_chromosomes.size(); i++) {
+                chromosome_stream.write(half_chromosomes[i]);
+            }
+            storage.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                        best_chromo.data(), half_len, half_dim, num_bats, MODE_COMPUTE, OBJ_SUM_SQUARES, false,
+                        0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+            
+            // The kernel must match the reference on the vectors it stores;
+            // the distance to the full-precision reference is the storage cost
+            for (int bat = 0; bat < num_bats; bat++) {
+                if (result_stream.empty()) {
+                    std::cout << "  [ERROR: " << storage.name << " returned " << bat << "/" << num_bats
+                              << " results]\n";
+                    errors++;
+                    break;
+                }
+                float hw_fitness = result_stream.read();
+                std::vector<packed_t> chromosome(half_chromosomes.begin() + bat * half_chunks,
+                                                 half_chromosomes.begin() + (bat + 1) * half_chunks);
+                float cpu_stored = cpu_reference_double(rounded_vectors, chromosome, half_len, half_dim);
+                float cpu_full = cpu_reference_double(half_vectors, chromosome, half_len, half_dim);
+                float diff, rel_error, full_diff, full_rel_error;
+                bool match = compare_floats(hw_fitness, cpu_stored, diff, rel_error);
+                if (exact_mode) match = hw_fitness == cpu_stored;
+                compare_floats(hw_fitness, cpu_full, full_diff, full_rel_error);
+                if (full_rel_error > storage_rel_error) storage_rel_error = full_rel_error;
+                
+                std::cout << "  " << storage.name << (load_mode == MODE_LOAD ? " (mode=1)" : " (mode=3)")
+                          << " bat " << bat << ": HW " << hw_fitness << ", CPU on stored " << cpu_stored
+                          << ", CPU full precision " << cpu_full;
+                if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) {
+                    std::cout << " [ERROR: Significant mismatch!]\n";
+                    errors++;
+                } else {
+                    std::cout << " [OK]\n";
+                }
+            }
+        }
+        std::cout << "  " << storage.name << ": " << half_len << " genes x " << half_dim << " dims, "
+                  << half_beats.size() << " beats to load, max error vs cpu_reference_double "
+                  << (storage_rel_error * 100) << "%\n";
+    }
+    
+    // ==== TEST 18: URAM-BACKED CACHE ====
+    std::cout << "\n[TEST 18] Filling fitness_top_uram's cache (" << URAM_MAX_GENES << " genes x "
+              << URAM_MAX_DIM << " dims, bf16)...\n";
+    
+    const int uram_chunks = (URAM_MAX_GENES + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<float> uram_vectors(URAM_MAX_GENES * URAM_MAX_DIM);
+    for (size_t i = 0; i < uram_vectors.size(); i++) {
+        uram_vectors[i] = exact_mode ? static_cast<float>(rand() % 21 - 10) : random_float(-10.0f, 10.0f);
+    }
+    std::vector<float> uram_stored;
+    std::vector<wide_t> uram_beats = pack_halves<bf16_t>(uram_vectors, uram_stored);
+    std::vector<packed_t> uram_chromosomes;
+    for (int bat = 0; bat < num_bats; bat++) {
+        for (int i = 0; i < uram_chunks; i++) {
+            uram_chromosomes.push_back(generate_random_chunk(i, URAM_MAX_GENES));
+        }
+    }
+    
+    fitness_top_uram(chromosome_stream, result_stream, record_stream, vectors_in, uram_beats.data(),
+                     best_chromo.data(), URAM_MAX_GENES, URAM_MAX_DIM, num_bats, MODE_LOAD_WIDE,
+                     OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    result_stream.read();
+    for (size_t i = 0; i < uram_chromosomes.size(); i++) {
+        chromosome_stream.write(uram_chromosomes[i]);
+    }
+    fitness_top_uram(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                     best_chromo.data(), URAM_MAX_GENES, URAM_MAX_DIM, num_bats, MODE_COMPUTE,
+                     OBJ_SUM_SQUARES, false, 0.0f, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    int uram_received = 0;
+    errors += verify_results(result_stream, uram_stored, uram_chromosomes, URAM_MAX_GENES, URAM_MAX_DIM,
+                             uram_received, max_abs_error, max_rel_error);
+    if (uram_received != num_bats) {
+        std::cout << "\nERROR: Expected " << num_bats << " results from fitness_top_uram, got "
+                  << uram_received << "\n";
+        errors++;
+    }
+    std::cout << "  " << uram_vectors.size() << " elements on-chip, "
+              << static_cast<float>(uram_vectors.size()) / (MAX_GENES * MAX_DIM) << "x fitness_kernel's cache\n";
+    
+    // ==== TEST 19: ACCUMULATION ACCURACY ====
+    std::cout << "\n[TEST 19] Small differences of large sums, accumulator: " << acc_mode_name << "...\n";
+    
+    // Every gene carries a large common offset and every bat is balanced, so
+    // the offsets cancel and sumA - sumB is a small residue of sums ~1e5
+    const int drift_len = MAX_GENES;
+    const int drift_dim = dim;
+    const int drift_chunks = (drift_len + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK;
+    std::vector<float> drift_vectors(drift_len * drift_dim);
+    for (size_t i = 0; i < drift_vectors.size(); i++) {
+        drift_vectors[i] = 100.0f + (exact_mode ? static_cast<float>(rand() % 21 - 10) : random_float(-1.0f, 1.0f));
+    }
+    std::vector<packed_t> drift_chromosomes(num_bats * drift_chunks, packed_t(0));
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<int> genes(drift_len);
+        for (int g = 0; g < drift_len; g++) genes[g] = g;
+        for (int g = 0; g < drift_len / 2; g++) {
+            int pick = g + rand() % (drift_len - g);
+            std::swap(genes[g], genes[pick]);
+            drift_chromosomes[bat * drift_chunks + genes[g] / BITS_PER_CHUNK].set_bit(genes[g] % BITS_PER_CHUNK, 1);
+        }
+    }
+    
+    fitness_kernel(chromosome_stream, result_stream, record_stream, drift_vectors.data(), vectors_wide,
+                   best_chromo.data(), drift_len, drift_dim, num_bats, MODE_LOAD, OBJ_SUM_SQUARES, false, 0.0f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    result_stream.read();
+    for (size_t i = 0; i < drift_chromosomes.size(); i++) {
+        chromosome_stream.write(drift_chromosomes[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), drift_len, drift_dim, num_bats, MODE_COMPUTE, OBJ_SUM_SQUARES, true, 0.0f,
+                   0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    
+    double drift_diff_error = 0.0;
+    double drift_fitness_error = 0.0;
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> chromosome(drift_chromosomes.begin() + bat * drift_chunks,
+                                         drift_chromosomes.begin() + (bat + 1) * drift_chunks);
+        std::vector<double> cpu_diff = cpu_difference_double(drift_vectors, chromosome, drift_len, drift_dim);
+        double cpu_fitness = 0.0;
+        for (int d = 0; d < drift_dim; d++) cpu_fitness += cpu_diff[d] * cpu_diff[d];
+        
+        float hw_fitness = result_stream.read();
+        for (int d = 0; d < drift_dim; d++) {
+            drift_diff_error = fmax(drift_diff_error, fabs(result_stream.read() - cpu_diff[d]));
+        }
+        result_stream.read();  // argmax index
+        drift_fitness_error = fmax(drift_fitness_error, fabs(hw_fitness - cpu_fitness) / cpu_fitness);
+    }
+    
+    // One gene step per cycle in every mode; a longer accumulate path only
+    // deepens the pipeline, which each bat pays once
+    const int drift_steps = drift_chunks + drift_len / 2 + drift_dim;
+    const int drift_depth = acc_path_adds * fadd_latency;
+    std::cout << "  Max |sumA - sumB| error: " << drift_diff_error << " (sums up to "
+              << 100.0 * drift_len << "), max fitness rel error: " << (drift_fitness_error * 100) << "%\n";
+    std::cout << "  Modeled cycles per bat: " << drift_steps << " gene steps + " << drift_depth
+              << " pipeline depth, " << (100.0 * drift_depth / (drift_steps + drift_depth))
+              << "% of the pass\n";
+    
+    // Exact sums on integers, near-double with compensation; plain float
+    // sums are only reported, they drift with the gene count
+    bool drift_ok = true;
+#ifdef FITNESS_ACC_COMPENSATED
+    drift_ok = drift_fitness_error < 1e-5;
+#endif
+    if (exact_mode) drift_ok = drift_diff_error == 0.0;
+    if (drift_ok) {
+        std::cout << "  [OK]\n";
+    } else {
+        std::cout << "  [ERROR: accumulation error above the " << acc_mode_name << " bound]\n";
+        errors++;
+    }
+    
+    // ==== TEST 20: DUPLICATE FILTER ====
+    std::cout << "\n[TEST 20] Repeated chromosomes through the " << MEMO_ENTRIES << "-entry duplicate filter...\n";
+    
+    // Four distinct chromosomes, one differing from bat 0 only in its last
+    // gene, repeated over twelve bats
+    std::vector<packed_t> dup_distinct(chromosome_data);
+    dup_distinct.insert(dup_distinct.end(), chromosome_data.begin(), chromosome_data.begin() + num_chunks);
+    packed_t& dup_last = dup_distinct[4 * num_chunks - 1];
+    dup_last.set_bit((chromo_len - 1) % BITS_PER_CHUNK, !dup_last[(chromo_len - 1) % BITS_PER_CHUNK]);
+    std::vector<packed_t> dup_population;
+    for (int bat = 0; bat < 12; bat++) {
+        dup_population.insert(dup_population.end(), dup_distinct.begin() + (bat % 4) * num_chunks,
+                              dup_distinct.begin() + (bat % 4 + 1) * num_chunks);
+    }
+    // MEMO_ENTRIES + 1 fresh chromosomes twice in a row: each is replaced
+    // just before it comes back, so nothing hits
+    std::vector<packed_t> cycle_population;
+    for (int c = 0; c <= MEMO_ENTRIES; c++) {
+        for (int i = 0; i < num_chunks; i++) cycle_population.push_back(generate_random_chunk(i, chromo_len));
+    }
+    cycle_population.insert(cycle_population.end(), cycle_population.begin(), cycle_population.end());
+    
+    struct memo_pass {
+        const std::vector<packed_t>* population;
+        int objective;
+        float prune_threshold;
+        unsigned int lookups;
+        unsigned int hits;
+    };
+    const memo_pass memo_passes[] = {
+        { &dup_population, OBJ_SUM_SQUARES, 0.0f, 12, 8 },
+        { &dup_population, OBJ_MAX_ABS, 0.0f, 12, 12 },    // stored differences, new objective
+        { &dup_population, OBJ_MAX_ABS, 1.0e9f, 0, 0 },    // pruning turns the filter off
+        { &cycle_population, OBJ_SUM_SQUARES, 0.0f, 2 * (MEMO_ENTRIES + 1), 0 },
+    };
+    const variant_case memo_tops[] = {
+        { "fitness_kernel", fitness_kernel, chromo_len, dim },
+        { "fitness_top", fitness_top, chromo_len, dim },
+    };
+    for (const variant_case& variant : memo_tops) {
+        variant.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                    best_chromo.data(), chromo_len, dim, num_bats, MODE_LOAD, OBJ_SUM_SQUARES, false, 0.0f, 0,
+                    0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        result_stream.read();
+        if (memo_lookups != 0 || memo_hits != 0) {
+            std::cout << "  [ERROR: " << variant.name << " kept " << memo_lookups << " lookups / " << memo_hits
+                      << " hits across a load]\n";
+            errors++;
+        }
+        
+        for (const memo_pass& pass : memo_passes) {
+            const int pass_bats = static_cast<int>(pass.population->size()) / num_chunks;
+            const unsigned int prev_lookups = memo_lookups;
+            const unsigned int prev_hits = memo_hits;
+            for (size_t i = 0; i < pass.population->size(); i++) {
+                chromosome_stream.write((*pass.population)[i]);
+            }
+            variant.top(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                        best_chromo.data(), chromo_len, dim, pass_bats, MODE_COMPUTE, pass.objective, false,
+                        pass.prune_threshold, 0, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+            
+            int mismatches = 0;
+            for (int bat = 0; bat < pass_bats; bat++) {
+                std::vector<packed_t> chromosome(pass.population->begin() + bat * num_chunks,
+                                                 pass.population->begin() + (bat + 1) * num_chunks);
+                float cpu_fitness = cpu_reference_double(wide_vectors_vec, chromosome, chromo_len, dim,
+                                                         pass.objective);
+                float hw_fitness = result_stream.read();
+                float diff, rel_error;
+                bool match = compare_floats(hw_fitness, cpu_fitness, diff, rel_error);
+                if (exact_mode) match = hw_fitness == cpu_fitness;
+                if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) mismatches++;
+            }
+            
+            const unsigned int pass_lookups = memo_lookups - prev_lookups;
+            const unsigned int pass_hits = memo_hits - prev_hits;
+            std::cout << "  " << variant.name << ": " << pass_bats << " bats, objective " << pass.objective
+                      << (pass.prune_threshold > 0.0f ? ", pruning" : "") << ": " << pass_lookups
+                      << " lookups, " << pass_hits << " hits";
+            if (mismatches > 0) {
+                std::cout << " [ERROR: " << mismatches << " fitness mismatches]\n";
+                errors++;
+            } else if (pass_lookups != pass.lookups || pass_hits != pass.hits) {
+                std::cout << " [ERROR: expected " << pass.lookups << " lookups, " << pass.hits << " hits]\n";
+                errors++;
+            } else {
+                std::cout << " [OK]\n";
+            }
+        }
+    }
+    
+    // ==== TEST 21: ONE-FLIP NEIGHBORHOOD SCAN ====
+    std::cout << "\n[TEST 21] Scoring every single-gene flip (mode=9)...\n";
+    
+    // fitness_kernel still holds vectors_in from TEST 20. Full flip list,
+    // then the best flip only, which MODE_INCREMENTAL then applies
+    std::vector<int> scan_best_gene(num_bats, -1);
+    std::vector<float> scan_best_fitness(num_bats, 0.0f);
+    for (int pass = 0; pass < 2; pass++) {
+        const int scan_objective = pass == 0 ? OBJ_SUM_SQUARES : OBJ_MAX_ABS;
+        const int scan_top_k = pass == 0 ? 0 : 1;
+        for (size_t i = 0; i < chromosome_data.size(); i++) {
+            chromosome_stream.write(chromosome_data[i]);
+        }
+        fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                       best_chromo.data(), chromo_len, dim, num_bats, MODE_SCAN, scan_objective, false, 0.0f,
+                       scan_top_k, 0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+        
+        for (int bat = 0; bat < num_bats; bat++) {
+            std::vector<packed_t> chromosome(chromosome_data.begin() + bat * num_chunks,
+                                             chromosome_data.begin() + (bat + 1) * num_chunks);
+            std::vector<float> cpu_neighbors(chromo_len);
+            int cpu_best = 0;
+            for (int gene = 0; gene < chromo_len; gene++) {
+                std::vector<packed_t> neighbor(chromosome);
+                packed_t& chunk = neighbor[gene / BITS_PER_CHUNK];
+                chunk.set_bit(gene % BITS_PER_CHUNK, !chunk[gene % BITS_PER_CHUNK]);
+                cpu_neighbors[gene] = cpu_reference_double(wide_vectors_vec, neighbor, chromo_len, dim,
+                                                           scan_objective);
+                if (cpu_neighbors[gene] < cpu_neighbors[cpu_best]) cpu_best = gene;
+            }
+            
+            // The bat itself, then its flips, each against a full re-evaluation
+            std::vector<float> hw_values(1, result_stream.read());
+            std::vector<float> cpu_values(1, cpu_reference_double(wide_vectors_vec, chromosome, chromo_len,
+                                                                  dim, scan_objective));
+            int hw_gene = -1;
+            if (scan_top_k == 0) {
+                for (int gene = 0; gene < chromo_len; gene++) {
+                    hw_values.push_back(result_stream.read());
+                    cpu_values.push_back(cpu_neighbors[gene]);
+                }
+            } else {
+                hw_values.push_back(result_stream.read());
+                hw_gene = static_cast<int>(result_stream.read());
+                cpu_values.push_back(hw_gene >= 0 && hw_gene < chromo_len ? cpu_neighbors[hw_gene] : -1.0f);
+            }
+            int mismatches = 0;
+            for (size_t i = 0; i < hw_values.size(); i++) {
+                float diff, rel_error;
+                bool match = compare_floats(hw_values[i], cpu_values[i], diff, rel_error);
+                if (exact_mode) match = hw_values[i] == cpu_values[i];
+                if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) mismatches++;
+            }
+            
+            std::cout << "  Bat " << bat << ", objective " << scan_objective << ": fitness " << hw_values[0];
+            if (scan_top_k == 0) {
+                std::cout << ", " << chromo_len << " flips, best " << cpu_best << " -> "
+                          << cpu_neighbors[cpu_best];
+            } else {
+                std::cout << ", best flip " << hw_gene << " -> " << hw_values[1] << " (CPU " << cpu_best
+                          << " -> " << cpu_neighbors[cpu_best] << ")";
+            }
+            // Another gene is only acceptable as a tie
+            bool best_ok = scan_top_k == 0 || hw_gene == cpu_best ||
+                           (!exact_mode && hw_gene >= 0 && hw_gene < chromo_len &&
+                            cpu_neighbors[hw_gene] - cpu_neighbors[cpu_best] <= 0.1f);
+            if (mismatches > 0) {
+                std::cout << " [ERROR: " << mismatches << " fitness mismatches]\n";
+                errors++;
+            } else if (!best_ok) {
+                std::cout << " [ERROR: not the best flip]\n";
+                errors++;
+            } else {
+                std::cout << " [OK]\n";
+            }
+            if (scan_top_k > 0) {
+                scan_best_gene[bat] = hw_gene;
+                scan_best_fitness[bat] = hw_values[1];
+            }
+        }
+    }
+    
+    // Take each bat's best flip on the resident state
+    for (int bat = 0; bat < num_bats; bat++) {
+        chromosome_stream.write(packed_t(1));
+        chromosome_stream.write(packed_t(scan_best_gene[bat] < 0 ? 0 : scan_best_gene[bat]));
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_INCREMENTAL, OBJ_MAX_ABS, false, 0.0f, 0,
+                   0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    for (int bat = 0; bat < num_bats; bat++) {
+        float moved_fitness = result_stream.read();
+        float diff, rel_error;
+        bool match = compare_floats(moved_fitness, scan_best_fitness[bat], diff, rel_error);
+        if (exact_mode) match = moved_fitness == scan_best_fitness[bat];
+        std::cout << "  Bat " << bat << " after flipping gene " << scan_best_gene[bat] << ": " << moved_fitness;
+        if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) {
+            std::cout << " [ERROR: expected " << scan_best_fitness[bat] << "]\n";
+            errors++;
+        } else {
+            std::cout << " [OK]\n";
+        }
+    }
+    
+    // ==== TEST 22: CHROMOSOME PADDING ====
+    std::cout << "\n[TEST 22] Chromosomes with random bits past chromo_len...\n";
+    
+    // The last chunk's padding carries no genes: counts, side choice and
+    // chunk hand-off must all ignore it
+    std::vector<packed_t> padded_data = with_padding(chromosome_data, chromo_len);
+    for (size_t i = 0; i < padded_data.size(); i++) {
+        chromosome_stream.write(padded_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_COMPUTE, OBJ_SUM_SQUARES, false, 0.0f, 0,
+                   0, 0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    int padded_received = 0;
+    errors += verify_results(result_stream, wide_vectors_vec, padded_data, chromo_len, dim, padded_received,
+                             max_abs_error, max_rel_error);
+    if (padded_received != num_bats || !chromosome_stream.empty()) {
+        std::cout << "\nERROR: Expected " << num_bats << " results and a drained chromosome stream, got "
+                  << padded_received << "\n";
+        errors++;
+        while (!chromosome_stream.empty()) chromosome_stream.read();
+    }
+    
+    // The one-flip scan of the same chromosomes: the bat, then every flip
+    for (size_t i = 0; i < padded_data.size(); i++) {
+        chromosome_stream.write(padded_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_SCAN, OBJ_SUM_SQUARES, false, 0.0f, 0, 0,
+                   0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    for (int bat = 0; bat < num_bats; bat++) {
+        std::vector<packed_t> chromosome(padded_data.begin() + bat * num_chunks,
+                                         padded_data.begin() + (bat + 1) * num_chunks);
+        int mismatches = 0;
+        for (int gene = -1; gene < chromo_len; gene++) {
+            std::vector<packed_t> neighbor(chromosome);
+            if (gene >= 0) {
+                packed_t& chunk = neighbor[gene / BITS_PER_CHUNK];
+                chunk.set_bit(gene % BITS_PER_CHUNK, !chunk[gene % BITS_PER_CHUNK]);
+            }
+            const float hw_value = result_stream.read();
+            const float cpu_value = cpu_reference_double(wide_vectors_vec, neighbor, chromo_len, dim);
+            float diff, rel_error;
+            bool match = compare_floats(hw_value, cpu_value, diff, rel_error);
+            if (exact_mode) match = hw_value == cpu_value;
+            if (!match && (exact_mode || diff > 0.1f || rel_error > 0.001f)) mismatches++;
+        }
+        std::cout << "  Scan of padded bat " << bat << ": " << chromo_len << " flips";
+        if (mismatches > 0) {
+            std::cout << " [ERROR: " << mismatches << " fitness mismatches]\n";
+            errors++;
+        } else {
+            std::cout << " [OK]\n";
+        }
+    }
+    
+    // Seeded by MODE_BAT without generations, the resident population keeps
+    // its padding; flip-free incremental records must count genes only
+    for (size_t i = 0; i < padded_data.size(); i++) {
+        chromosome_stream.write(padded_data[i]);
+    }
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_BAT, OBJ_SUM_SQUARES, false, 0.0f, 0, 0,
+                   0, 0, 0, 0, false, &memo_lookups, &memo_hits);
+    while (!result_stream.empty()) result_stream.read();
+    for (int bat = 0; bat < num_bats; bat++) chromosome_stream.write(packed_t(0));
+    fitness_kernel(chromosome_stream, result_stream, record_stream, vectors_in, vectors_wide,
+                   best_chromo.data(), chromo_len, dim, num_bats, MODE_INCREMENTAL, OBJ_SUM_SQUARES, false, 0.0f,
+                   0, 0, 0, 0, 0, 0, true, &memo_lookups, &memo_hits);
+    result_beat_t padded_beat = 0;
+    for (int bat = 0; bat < num_bats; bat++) {
+        if (bat % RESULT_RECORDS == 0) padded_beat = record_stream.read();
+        ap_uint<64> record = padded_beat.range(64 * (bat % RESULT_RECORDS) + 63, 64 * (bat % RESULT_RECORDS));
+        const int ones = record.range(63, 48).to_int();
+        int cpu_ones = 0;
+        for (int gene_idx = 0; gene_idx < chromo_len; gene_idx++) {
+            cpu_ones += padded_data[bat * num_chunks + gene_idx / BITS_PER_CHUNK][gene_idx % BITS_PER_CHUNK] ? 1 : 0;
+        }
+        std::cout << "  Bat engine resident " << bat << ": popcount " << ones << "/" << cpu_ones;
+        if (ones != cpu_ones) {
+            std::cout << " [ERROR: popcount mismatch]\n";
+            errors++;
+        } else {
+            std::cout << " [OK]\n";
+        }
     }
+    while (!record_stream.empty()) record_stream.read();
     
     // ==== SUMMARY ====
     std::cout << "\n========================================\n";
@@ -269,6 +2008,7 @@ int main() {
     
     // Cleanup
     delete[] vectors_in;
+    delete[] vectors_wide;
     
     if (errors == 0) {
         std::cout << "\nSUCCESS: All tests passed within acceptable tolerance!\n";